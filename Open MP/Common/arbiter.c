@@ -0,0 +1,130 @@
+#include "arbiter.h"
+
+#include <limits.h>
+#include <sched.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+// Sleeps while *word is still expected. Spurious wake ups are fine, every caller checks again
+static void futex_wait(atomic_int *word, int expected)
+{
+#ifdef __linux__
+    syscall(SYS_futex, (int *)word, FUTEX_WAIT_PRIVATE, expected, NULL, NULL, 0);
+#else
+    if (atomic_load_explicit(word, memory_order_relaxed) == expected)
+    {
+        sched_yield();
+    }
+#endif
+}
+
+// Wakes up to n threads sleeping on word
+static void futex_wake(atomic_int *word, int n)
+{
+#ifdef __linux__
+    syscall(SYS_futex, (int *)word, FUTEX_WAKE_PRIVATE, n, NULL, NULL, 0);
+#else
+    (void)word;
+    (void)n;
+#endif
+}
+
+void chopstick_init(chopstick *c)
+{
+    atomic_init(&c->state, 0);
+}
+
+// The three state mutex from Drepper's "Futexes Are Tricky": putting down a chopstick only makes
+// a system call when the state says someone may be asleep
+void chopstick_pick_up(chopstick *c)
+{
+    int state = 0;
+    if (atomic_compare_exchange_strong_explicit(&c->state, &state, 1, memory_order_acquire, memory_order_relaxed))
+    {
+        return;
+    }
+
+    // Mark the chopstick contended, then sleep until it comes back free
+    if (state != 2)
+    {
+        state = atomic_exchange_explicit(&c->state, 2, memory_order_acquire);
+    }
+    while (state != 0)
+    {
+        futex_wait(&c->state, 2);
+        state = atomic_exchange_explicit(&c->state, 2, memory_order_acquire);
+    }
+}
+
+void chopstick_put_down(chopstick *c)
+{
+    if (atomic_fetch_sub_explicit(&c->state, 1, memory_order_release) != 1)
+    {
+        atomic_store_explicit(&c->state, 0, memory_order_release);
+        futex_wake(&c->state, 1);
+    }
+}
+
+void table_pick_up(chopstick sticks[], int n_seats, int seat)
+{
+    int left = seat;
+    int right = (seat + 1) % n_seats;
+    if (left == right)
+    {
+        chopstick_pick_up(&sticks[left]);
+        return;
+    }
+    chopstick_pick_up(&sticks[left < right ? left : right]);
+    chopstick_pick_up(&sticks[left < right ? right : left]);
+}
+
+void table_put_down(chopstick sticks[], int n_seats, int seat)
+{
+    int left = seat;
+    int right = (seat + 1) % n_seats;
+    chopstick_put_down(&sticks[left]);
+    if (left != right)
+    {
+        chopstick_put_down(&sticks[right]);
+    }
+}
+
+void semaphore_init(semaphore *s, int count)
+{
+    atomic_init(&s->count, count);
+    atomic_init(&s->waiters, 0);
+}
+
+void semaphore_wait(semaphore *s)
+{
+    for (;;)
+    {
+        int count = atomic_load_explicit(&s->count, memory_order_relaxed);
+        while (count > 0)
+        {
+            if (atomic_compare_exchange_weak_explicit(&s->count, &count, count - 1, memory_order_acquire,
+                                                      memory_order_relaxed))
+            {
+                return;
+            }
+        }
+
+        // Nothing left: sleep until a post changes the count from 0
+        atomic_fetch_add_explicit(&s->waiters, 1, memory_order_seq_cst);
+        futex_wait(&s->count, 0);
+        atomic_fetch_sub_explicit(&s->waiters, 1, memory_order_relaxed);
+    }
+}
+
+void semaphore_post(semaphore *s)
+{
+    atomic_fetch_add_explicit(&s->count, 1, memory_order_seq_cst);
+    if (atomic_load_explicit(&s->waiters, memory_order_seq_cst) > 0)
+    {
+        futex_wake(&s->count, 1);
+    }
+}
@@ -0,0 +1,65 @@
+#ifndef ARBITER_H
+#define ARBITER_H
+
+#include <stdatomic.h>
+
+#include "padded.h"
+
+// Blocking primitives for threads competing over shared resources, such as the chopsticks of the
+// dining philosophers. A thread that has to wait sleeps in the kernel on a futex instead of spinning
+// on a lock, and the uncontended paths are a single atomic compare and swap. Systems without futexes
+// fall back to yielding the CPU between attempts
+
+// chopstick -> A lock one philosopher holds at a time, alone on its cache line so neighbouring
+//  chopsticks do not false share
+//
+// FIELDS
+//  - atomic_int state -> 0 when free, 1 when held, 2 when held and someone may be sleeping on it
+typedef struct
+{
+    _Alignas(CACHE_LINE_SIZE) atomic_int state;
+} chopstick;
+
+// semaphore -> A counting semaphore
+//
+// FIELDS
+//  - atomic_int count -> The number of units left
+//  - atomic_int waiters -> The number of threads sleeping until a unit is returned
+typedef struct
+{
+    _Alignas(CACHE_LINE_SIZE) atomic_int count;
+    atomic_int waiters;
+} semaphore;
+
+// void chopstick_init() -> Makes a chopstick free
+void chopstick_init(chopstick *c);
+
+// void chopstick_pick_up() -> Takes the chopstick, sleeping until it is free
+void chopstick_pick_up(chopstick *c);
+
+// void chopstick_put_down() -> Frees the chopstick and wakes one sleeping thread if there is one
+void chopstick_put_down(chopstick *c);
+
+// void table_pick_up() -> Takes both chopsticks next to a seat, the lower numbered one first. With
+//  every philosopher taking them in the same global order there is no cycle of philosophers each
+//  holding one chopstick and waiting for the next, so no deadlock and no need for a semaphore
+//
+// INPUTS
+//  - chopstick sticks[] -> The chopsticks around the table, one per seat
+//  - int n_seats -> The number of seats (and chopsticks)
+//  - int seat -> The philosopher's seat. Its chopsticks are seat and seat + 1 (wrapping around)
+void table_pick_up(chopstick sticks[], int n_seats, int seat);
+
+// void table_put_down() -> Puts down both chopsticks next to a seat
+void table_put_down(chopstick sticks[], int n_seats, int seat);
+
+// void semaphore_init() -> Sets the number of units
+void semaphore_init(semaphore *s, int count);
+
+// void semaphore_wait() -> Takes one unit, sleeping until one is available
+void semaphore_wait(semaphore *s);
+
+// void semaphore_post() -> Returns one unit and wakes one sleeping thread if there is one
+void semaphore_post(semaphore *s);
+
+#endif
@@ -0,0 +1,135 @@
+#include "arena.h"
+#include "buffer.h"
+#include "padded.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+static size_t page_size(void)
+{
+    long size = sysconf(_SC_PAGESIZE);
+    return size > 0 ? (size_t)size : 4096;
+}
+
+// Allocates the region and writes one byte per page so every page is faulted in up front,
+// by the same threads (and so on the same NUMA nodes) as buffer_alloc()
+static void arena_map(arena *a, size_t size)
+{
+    size_t rounded = (size + BUFFER_ALIGNMENT - 1) / BUFFER_ALIGNMENT * BUFFER_ALIGNMENT;
+    a->base = NULL;
+    a->size = 0;
+    if (rounded == 0)
+    {
+        return;
+    }
+
+    a->base = aligned_alloc(BUFFER_ALIGNMENT, rounded);
+    if (a->base == NULL)
+    {
+        printf("Error allocating %zu bytes!\n", rounded);
+        exit(1);
+    }
+#ifdef MADV_HUGEPAGE
+    madvise(a->base, rounded, MADV_HUGEPAGE);
+#endif
+
+    long n_pages = (long)(rounded / page_size());
+    char *base = a->base;
+    size_t page = page_size();
+#pragma omp parallel for schedule(static) num_threads(a->n_threads)
+    for (long p = 0; p < n_pages; p++)
+    {
+        base[p * page] = 0;
+    }
+    a->size = rounded;
+}
+
+arena arena_create(size_t size, int n_threads)
+{
+    arena a = {0};
+    a.n_threads = n_threads > 0 ? n_threads : 1;
+    arena_map(&a, size);
+    return a;
+}
+
+void *arena_alloc(arena *a, size_t bytes)
+{
+    if (a == NULL)
+    {
+        return malloc(bytes > 0 ? bytes : 1);
+    }
+
+    // Round every allocation up to a whole cache line so neighbours never share one
+    size_t aligned = (bytes + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+    if (aligned == 0)
+    {
+        aligned = CACHE_LINE_SIZE;
+    }
+    a->allocations++;
+    a->demand += aligned;
+    if (a->demand > a->high_water)
+    {
+        a->high_water = a->demand;
+    }
+
+    if (a->used + aligned <= a->size)
+    {
+        void *ptr = a->base + a->used;
+        a->used += aligned;
+        a->allocations_avoided++;
+        return ptr;
+    }
+
+    // It does not fit, so take it from malloc until the next reset grows the region
+    if (a->n_overflow == a->overflow_cap)
+    {
+        a->overflow_cap = a->overflow_cap > 0 ? 2 * a->overflow_cap : 8;
+        a->overflow = realloc(a->overflow, a->overflow_cap * sizeof(void *));
+    }
+    void *ptr = aligned_alloc(CACHE_LINE_SIZE, aligned);
+    a->overflow[a->n_overflow] = ptr;
+    a->n_overflow++;
+    return ptr;
+}
+
+void arena_release(arena *a, void *ptr)
+{
+    if (a == NULL)
+    {
+        free(ptr);
+    }
+}
+
+void arena_reset(arena *a)
+{
+    for (int i = 0; i < a->n_overflow; i++)
+    {
+        free(a->overflow[i]);
+    }
+    a->n_overflow = 0;
+
+    if (a->high_water > a->size)
+    {
+        free(a->base);
+        arena_map(a, a->high_water);
+    }
+    a->used = 0;
+    a->demand = 0;
+}
+
+void arena_destroy(arena *a)
+{
+    for (int i = 0; i < a->n_overflow; i++)
+    {
+        free(a->overflow[i]);
+    }
+    a->n_overflow = 0;
+    free(a->base);
+    free(a->overflow);
+    a->base = NULL;
+    a->overflow = NULL;
+    a->size = 0;
+    a->overflow_cap = 0;
+}
@@ -0,0 +1,67 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+// arena -> One pre-faulted region that a kernel's scratch and result arrays are carved out of.
+//  Allocations bump a pointer and are never freed one by one. arena_reset() hands the whole region
+//  back for the next run, so repeated runs reuse the same pages instead of going back to malloc
+//  and faulting fresh pages in. Requests that do not fit fall back to malloc, and the next reset
+//  grows the region to the most any run has asked for. Not thread safe: allocate outside
+//  parallel regions
+//
+// FIELDS
+//  - char* base -> The start of the region
+//  - size_t size -> The size of the region in bytes
+//  - size_t used -> How much of the region this run has handed out
+//  - size_t demand -> How much this run has asked for, including what overflowed to malloc
+//  - size_t high_water -> The largest demand of any run
+//  - int n_threads -> The number of threads that pre-fault the region
+//  - void** overflow -> The malloc fallbacks of this run, freed at the next reset
+//  - int n_overflow, overflow_cap -> The number of fallbacks and the room for them
+//  - long allocations -> Every arena_alloc() call
+//  - long allocations_avoided -> The calls served from the region instead of malloc
+typedef struct
+{
+    char *base;
+    size_t size;
+    size_t used;
+    size_t demand;
+    size_t high_water;
+    int n_threads;
+    void **overflow;
+    int n_overflow;
+    int overflow_cap;
+    long allocations;
+    long allocations_avoided;
+} arena;
+
+// arena arena_create() -> Allocates a region of at least size bytes aligned like buffer_alloc(),
+//  and touches every page of it in parallel so no kernel takes a page fault on it later
+//
+// INPUTS
+//  - size_t size -> The expected size of one run's allocations. 0 is fine: the first run then
+//      falls back to malloc and the first reset sizes the region
+//  - int n_threads -> The number of threads that should touch the pages
+arena arena_create(size_t size, int n_threads);
+
+// void* arena_alloc() -> Hands out bytes aligned to a cache line, from the region if they fit and
+//  from malloc otherwise. With a NULL arena it is plain malloc, so kernels can take an optional arena
+//
+// INPUTS
+//  - arena* a -> The arena to allocate from, or NULL
+//  - size_t bytes -> The number of bytes wanted
+void *arena_alloc(arena *a, size_t bytes);
+
+// void arena_release() -> Frees ptr if it came from malloc because a was NULL. Memory from an
+//  arena lives until arena_reset(), so with an arena this does nothing
+void arena_release(arena *a, void *ptr);
+
+// void arena_reset() -> Ends a run. Everything allocated since the last reset becomes invalid,
+//  the malloc fallbacks are freed and the region grows if the run did not fit in it
+void arena_reset(arena *a);
+
+// void arena_destroy() -> Releases the region and any fallbacks
+void arena_destroy(arena *a);
+
+#endif
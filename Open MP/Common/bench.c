@@ -0,0 +1,249 @@
+#include "bench.h"
+#include "profile.h"
+
+#include <math.h>
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+void bench_defaults(bench_config *cfg)
+{
+    cfg->n_thread_counts = 8;
+    for (int i = 0; i < cfg->n_thread_counts; i++)
+    {
+        cfg->threads[i] = i + 1;
+    }
+    cfg->warmup = 1;
+    cfg->reps = 5;
+    cfg->bind = NULL;
+    cfg->places = NULL;
+    cfg->dist.kind = RNG_UNIFORM;
+    cfg->dist.skew = 1.0;
+    cfg->seed = RNG_DEFAULT_SEED;
+    cfg->profile = NULL;
+}
+
+// bool parse_threads() -> Parses a comma separated list of thread counts and ranges, e.g. "1,2,4-8"
+static bool parse_threads(const char *arg, bench_config *cfg)
+{
+    int n = 0;
+    const char *p = arg;
+    while (*p != '\0')
+    {
+        char *end;
+        long first = strtol(p, &end, 10);
+        long last = first;
+        if (end == p)
+        {
+            return false;
+        }
+        if (*end == '-')
+        {
+            p = end + 1;
+            last = strtol(p, &end, 10);
+            if (end == p)
+            {
+                return false;
+            }
+        }
+        if (first < 1 || last < first || last > 4096)
+        {
+            return false;
+        }
+
+        for (long t = first; t <= last; t++)
+        {
+            if (n == BENCH_MAX_THREAD_COUNTS)
+            {
+                return false;
+            }
+            cfg->threads[n++] = (int)t;
+        }
+
+        if (*end == ',')
+        {
+            end++;
+        }
+        else if (*end != '\0')
+        {
+            return false;
+        }
+        p = end;
+    }
+
+    cfg->n_thread_counts = n;
+    return n > 0;
+}
+
+bool bench_option(int opt, const char *arg, bench_config *cfg)
+{
+    switch (opt)
+    {
+    case 't':
+        return parse_threads(arg, cfg);
+    case 'w':
+        cfg->warmup = atoi(arg);
+        return cfg->warmup >= 0;
+    case 'r':
+        cfg->reps = atoi(arg);
+        return cfg->reps >= 1;
+    case 'b':
+        cfg->bind = arg;
+        return true;
+    case 'p':
+        cfg->places = arg;
+        return true;
+    case 'd':
+        return rng_parse(arg, &cfg->dist);
+    case 'k':
+        cfg->seed = strtoull(arg, NULL, 0);
+        return true;
+    case 'P':
+        cfg->profile = arg;
+        return strcmp(arg, "time") == 0 || strcmp(arg, "counters") == 0 || strcmp(arg, "trace") == 0;
+    default:
+        return false;
+    }
+}
+
+// bool export_variable() -> Sets an environment variable, returning whether its value changed
+static bool export_variable(const char *name, const char *value, bool overwrite)
+{
+    const char *current = getenv(name);
+    if (value == NULL || (current != NULL && (!overwrite || strcmp(current, value) == 0)))
+    {
+        return false;
+    }
+    setenv(name, value, 1);
+    return true;
+}
+
+// void reexec_self() -> Runs this program again with the same arguments and the current environment
+static void reexec_self(void)
+{
+#ifdef __linux__
+    // /proc/self/cmdline holds the arguments, each terminated by a NUL
+    FILE *fp = fopen("/proc/self/cmdline", "r");
+    if (fp != NULL)
+    {
+        static char cmdline[1 << 16];
+        size_t n = fread(cmdline, 1, sizeof(cmdline) - 1, fp);
+        fclose(fp);
+        cmdline[n] = '\0';
+
+        char *args[1024];
+        int argc = 0;
+        for (size_t i = 0; i < n && argc < 1023; i += strlen(cmdline + i) + 1)
+        {
+            args[argc++] = cmdline + i;
+        }
+        args[argc] = NULL;
+
+        fflush(stdout);
+        execv("/proc/self/exe", args);
+    }
+    printf("Warning: could not restart to apply OMP_PROC_BIND and OMP_PLACES, the threads are not bound as asked \n");
+#else
+    printf("Warning: OMP_PROC_BIND and OMP_PLACES only apply when set before launch, the threads are not bound as asked \n");
+#endif
+}
+
+void bench_bind(const char *bind, const char *places, bool overwrite)
+{
+    bool changed = export_variable("OMP_PROC_BIND", bind, overwrite);
+    changed = export_variable("OMP_PLACES", places, overwrite) || changed;
+    if (changed)
+    {
+        reexec_self();
+    }
+}
+
+void bench_setup(const bench_config *cfg)
+{
+    bench_bind(cfg->bind, cfg->places, true);
+    if (!rng_self_test())
+    {
+        printf("Error: the Philox generator does not match its known answer, inputs would be wrong!\n");
+        exit(1);
+    }
+    if (cfg->profile != NULL)
+    {
+        profile_enable(strcmp(cfg->profile, "counters") == 0, strcmp(cfg->profile, "trace") == 0);
+    }
+}
+
+void bench_fill(const bench_config *cfg, int vals[], long len, int max_val)
+{
+    rng_fill(&cfg->dist, cfg->seed, vals, len, max_val, omp_get_max_threads());
+}
+
+static int compare_doubles(const void *a, const void *b)
+{
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+bench_stats bench_summarize(const double samples[], int n)
+{
+    bench_stats stats = {0, 0, 0, 0};
+    if (n < 1)
+    {
+        return stats;
+    }
+
+    double *sorted = malloc(n * sizeof(double));
+    memcpy(sorted, samples, n * sizeof(double));
+    qsort(sorted, n, sizeof(double), compare_doubles);
+
+    stats.median = n % 2 == 1 ? sorted[n / 2] : (sorted[n / 2 - 1] + sorted[n / 2]) / 2;
+    stats.p95 = sorted[(int)ceil(0.95 * n) - 1];
+
+    double sum = 0;
+    for (int i = 0; i < n; i++)
+    {
+        sum += sorted[i];
+    }
+    stats.mean = sum / n;
+
+    double squares = 0;
+    for (int i = 0; i < n; i++)
+    {
+        squares += (sorted[i] - stats.mean) * (sorted[i] - stats.mean);
+    }
+    stats.stddev = n > 1 ? sqrt(squares / (n - 1)) : 0;
+
+    free(sorted);
+    return stats;
+}
+
+void bench_write_header(FILE *fp, const char *name)
+{
+    fprintf(fp, ",%s Time,%s P95,%s Stddev", name, name, name);
+}
+
+void bench_write_stats(FILE *fp, bench_stats stats)
+{
+    fprintf(fp, ",%lf,%lf,%lf", stats.median, stats.p95, stats.stddev);
+}
+
+const char *bench_proc_bind_name(void)
+{
+    static const char *names[] = {"false", "true", "primary", "close", "spread"};
+    int bind = omp_get_proc_bind();
+    return bind >= 0 && bind <= 4 ? names[bind] : "unknown";
+}
+
+void bench_write_binding(FILE *fp, bool header)
+{
+    if (header)
+    {
+        fprintf(fp, ",Proc Bind,Places");
+        return;
+    }
+
+    // What the runtime reports, since a binding asked for after OpenMP started is silently ignored
+    fprintf(fp, ",%s,%d", bench_proc_bind_name(), omp_get_num_places());
+}
@@ -0,0 +1,107 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "rng.h"
+
+// The most thread counts one run can sweep over
+#define BENCH_MAX_THREAD_COUNTS 64
+
+// getopt() option letters handled by bench_option(), for drivers to add to their own
+#define BENCH_OPTIONS "t:w:r:b:p:d:k:P:"
+
+// Usage text for the options above
+#define BENCH_USAGE "[-t thread list e.g. 1,2,4-8] [-w warm up runs] [-r repetitions] [-b OMP_PROC_BIND] [-p OMP_PLACES] [-d uniform|zipf[:skew]|sorted] [-k seed] [-P time|counters|trace]"
+
+// bench_config -> How a driver sweeps its kernels
+//
+// FIELDS
+//  - int threads[] -> The thread counts to run, in order
+//  - int n_thread_counts -> How many entries of threads are used
+//  - int warmup -> Untimed runs before the timed ones at every thread count
+//  - int reps -> Timed runs at every thread count
+//  - const char* bind -> Value for OMP_PROC_BIND, or NULL to leave the environment alone
+//  - const char* places -> Value for OMP_PLACES, or NULL to leave the environment alone
+//  - rng_distribution dist -> The distribution generated inputs are drawn from
+//  - uint64_t seed -> The seed generated inputs are drawn with
+//  - const char* profile -> "time" to record per thread busy and idle time in every instrumented
+//      region (see profile.h), "counters" to read hardware counters as well, "trace" to record a
+//      timeline as well, or NULL for none of them
+typedef struct
+{
+    int threads[BENCH_MAX_THREAD_COUNTS];
+    int n_thread_counts;
+    int warmup;
+    int reps;
+    const char *bind;
+    const char *places;
+    rng_distribution dist;
+    uint64_t seed;
+    const char *profile;
+} bench_config;
+
+// bench_stats -> Summary of the timed runs of one kernel at one thread count
+typedef struct
+{
+    double median;
+    double p95;
+    double mean;
+    double stddev;
+} bench_stats;
+
+// void bench_defaults() -> Threads 1 through 8, one warm up run and five timed runs, and
+//  uniform inputs from RNG_DEFAULT_SEED
+void bench_defaults(bench_config *cfg);
+
+// bool bench_option() -> Handles one of the BENCH_OPTIONS options returned by getopt()
+//
+// INPUTS
+//  - int opt -> The option letter
+//  - const char* arg -> The option value (optarg)
+//  - bench_config* cfg -> The config to update
+//
+// Returns false if the option is not a harness option or its value is invalid
+bool bench_option(int opt, const char *arg, bench_config *cfg);
+
+// void bench_bind() -> Exports OMP_PROC_BIND and OMP_PLACES. OpenMP only reads them when the
+//  program is loaded, so if that changes either one the program re-executes itself (on Linux) with
+//  the same arguments to pick them up. Elsewhere it warns that they have to be set before launch.
+//  Anything done before this call is done again, so it has to come before the first OpenMP call
+//
+// INPUTS
+//  - const char* bind -> Value for OMP_PROC_BIND, or NULL to leave it alone
+//  - const char* places -> Value for OMP_PLACES, or NULL to leave it alone
+//  - bool overwrite -> Whether to replace values already in the environment
+void bench_bind(const char *bind, const char *places, bool overwrite);
+
+// void bench_setup() -> Applies the thread binding settings with bench_bind(), checks the input
+//  generator with rng_self_test() and starts profiling if it was asked for. It has to run before
+//  the driver's first OpenMP call
+void bench_setup(const bench_config *cfg);
+
+// void bench_fill() -> Fills vals with values in [1, max_val] from the configured distribution
+//  and seed, in parallel. Call it after bench_setup()
+void bench_fill(const bench_config *cfg, int vals[], long len, int max_val);
+
+// bench_stats bench_summarize() -> Median, 95th percentile (nearest rank), mean and sample
+//  standard deviation of n timings
+bench_stats bench_summarize(const double samples[], int n);
+
+// void bench_write_header() -> Writes the CSV header columns for one timed series:
+//  "<name> Time" (the median), "<name> P95" and "<name> Stddev", each preceded by a comma
+void bench_write_header(FILE *fp, const char *name);
+
+// void bench_write_stats() -> Writes the values for the columns bench_write_header() wrote
+void bench_write_stats(FILE *fp, bench_stats stats);
+
+// const char* bench_proc_bind_name() -> The binding policy the OpenMP runtime is using
+//  ("false", "true", "primary", "close" or "spread")
+const char *bench_proc_bind_name(void);
+
+// void bench_write_binding() -> Writes ",Proc Bind,Places" (header) or their values (row): the
+//  binding policy and number of places the OpenMP runtime is actually using, not what was asked for
+void bench_write_binding(FILE *fp, bool header);
+
+#endif
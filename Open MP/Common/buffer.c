@@ -0,0 +1,117 @@
+#include "buffer.h"
+
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+int_buffer buffer_alloc(size_t len, int n_threads)
+{
+    int_buffer buf = {NULL, len, false, 0};
+
+    // aligned_alloc needs the size to be a multiple of the alignment
+    size_t bytes = len * sizeof(int);
+    size_t rounded = (bytes + BUFFER_ALIGNMENT - 1) / BUFFER_ALIGNMENT * BUFFER_ALIGNMENT;
+    if (rounded == 0)
+    {
+        rounded = BUFFER_ALIGNMENT;
+    }
+
+    buf.data = aligned_alloc(BUFFER_ALIGNMENT, rounded);
+    if (buf.data == NULL)
+    {
+        printf("Error allocating %zu bytes!\n", rounded);
+        exit(1);
+    }
+#ifdef MADV_HUGEPAGE
+    madvise(buf.data, rounded, MADV_HUGEPAGE);
+#endif
+
+    // First touch every element with the same static schedule the kernels use
+    // so the page ends up on the memory node closest to the thread that uses it
+    long n = (long)len;
+#pragma omp parallel for schedule(static) num_threads(n_threads)
+    for (long i = 0; i < n; i++)
+    {
+        buf.data[i] = 0;
+    }
+
+    return buf;
+}
+
+bool buffer_map_file(const char *path, int_buffer *buf)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(int))
+    {
+        close(fd);
+        return false;
+    }
+
+    void *addr = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping stays valid after the descriptor is closed
+    close(fd);
+    if (addr == MAP_FAILED)
+    {
+        return false;
+    }
+    madvise(addr, st.st_size, MADV_SEQUENTIAL);
+
+    buf->data = addr;
+    buf->len = st.st_size / sizeof(int);
+    buf->mapped = true;
+    buf->mapped_bytes = st.st_size;
+    return true;
+}
+
+double buffer_copy(int_buffer *dst, const int_buffer *src, int n_threads)
+{
+    double start = omp_get_wtime();
+
+    // Each thread copies one contiguous slice so the stores stay local to its pages
+#pragma omp parallel num_threads(n_threads)
+    {
+        int tid = omp_get_thread_num();
+        int n = omp_get_num_threads();
+        size_t slice = (src->len + n - 1) / n;
+        size_t begin = tid * slice;
+        size_t end = begin + slice < src->len ? begin + slice : src->len;
+
+        if (begin < end)
+        {
+            memcpy(dst->data + begin, src->data + begin, (end - begin) * sizeof(int));
+        }
+    }
+
+    return omp_get_wtime() - start;
+}
+
+void buffer_free(int_buffer *buf)
+{
+    if (buf->data == NULL)
+    {
+        return;
+    }
+
+    if (buf->mapped)
+    {
+        munmap(buf->data, buf->mapped_bytes);
+    }
+    else
+    {
+        free(buf->data);
+    }
+
+    buf->data = NULL;
+    buf->len = 0;
+}
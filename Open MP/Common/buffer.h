@@ -0,0 +1,60 @@
+#ifndef BUFFER_H
+#define BUFFER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Alignment used for every heap buffer. 2MB lets the kernel back large
+// buffers with transparent huge pages, and is a multiple of the cache line
+#define BUFFER_ALIGNMENT (2 * 1024 * 1024)
+
+// int_buffer -> A large integer array that lives on the heap (or in a memory mapped file)
+//  instead of on the stack
+//
+// FIELDS
+//  - int* data -> A pointer to the first element of the buffer
+//  - size_t len -> The number of integers in the buffer
+//  - bool mapped -> Whether the data is a read only mapping of a file rather than heap memory
+//  - size_t mapped_bytes -> The size of the whole mapping, which stays the same when a driver
+//      shortens len to use only a prefix of the file
+typedef struct
+{
+    int *data;
+    size_t len;
+    bool mapped;
+    size_t mapped_bytes;
+} int_buffer;
+
+// int_buffer buffer_alloc() -> Allocates an aligned buffer of len integers on the heap.
+//  The pages are first touched in parallel with a static schedule so that each page
+//  is placed on the NUMA node of the thread that will later work on it
+//
+// INPUTS
+//  - size_t len -> The number of integers to allocate
+//  - int n_threads -> The number of threads that should touch the pages
+int_buffer buffer_alloc(size_t len, int n_threads);
+
+// bool buffer_map_file() -> Memory maps a binary file of native endian ints as a read only buffer
+//
+// INPUTS
+//  - const char* path -> The path of the binary input file
+//  - int_buffer* buf -> The buffer that will point at the mapping
+//
+// Returns false (and leaves buf untouched) if the file cannot be opened or mapped
+bool buffer_map_file(const char *path, int_buffer *buf);
+
+// double buffer_copy() -> Copies src into dst in parallel and returns the time it took
+//
+// INPUTS
+//  - int_buffer* dst -> The destination buffer, must be at least as long as src
+//  - const int_buffer* src -> The source buffer
+//  - int n_threads -> The number of threads that should do the copy
+double buffer_copy(int_buffer *dst, const int_buffer *src, int n_threads);
+
+// void buffer_free() -> Releases the memory held by a buffer (unmapping it if it is a file)
+//
+// INPUTS
+//  - int_buffer* buf -> The buffer to release
+void buffer_free(int_buffer *buf);
+
+#endif
@@ -0,0 +1,159 @@
+#include "gcd.h"
+
+int gcd_loop(int a, int b)
+{
+    if (a == 0)
+    {
+        return b;
+    }
+    else if (b == 0)
+    {
+        return a;
+    }
+
+    int result = ((a < b) ? a : b); // result = min(a, b)
+    while (result > 0)
+    {
+        if (a % result == 0 && b % result == 0)
+        {
+            break;
+        }
+        result--;
+    } // After exiting loop we have found gcd
+    return result;
+}
+
+int gcd_binary(int a, int b)
+{
+    unsigned x = (unsigned)a;
+    unsigned y = (unsigned)b;
+    if (x == 0)
+    {
+        return (int)y;
+    }
+    if (y == 0)
+    {
+        return (int)x;
+    }
+
+    // Pull out the power of two both share, then keep both values odd
+    int shift = __builtin_ctz(x | y);
+    x >>= __builtin_ctz(x);
+    while (y != 0)
+    {
+        y >>= __builtin_ctz(y);
+        if (x > y)
+        {
+            unsigned t = x;
+            x = y;
+            y = t;
+        }
+        y -= x;
+    }
+
+    return (int)(x << shift);
+}
+
+int gcd(int a, int b)
+{
+    // Reducing with gcd keeps a small running value in a, so one Euclid step
+    // shrinks b to below a before the Stein loop starts
+    if (a != 0 && b != 0)
+    {
+        b = (int)((unsigned)b % (unsigned)a);
+    }
+    return gcd_binary(a, b);
+}
+
+// void gcd_lanes() -> Sets acc[l] = gcd(acc[l], vals[l]) for every lane at once.
+//  Every step only uses compares, shifts, selects and subtracts so the loop over
+//  lanes turns into vector instructions. Each step after the first does one Stein step per lane:
+//  shift out a shared factor of two, shift out a factor of two from one side,
+//  or subtract the smaller odd value from the larger one
+static void gcd_lanes(unsigned acc[GCD_LANES], const int vals[GCD_LANES])
+{
+    unsigned x[GCD_LANES];
+    unsigned y[GCD_LANES];
+    unsigned k[GCD_LANES];
+    unsigned any = 0;
+
+#pragma omp simd reduction(| : any)
+    for (int l = 0; l < GCD_LANES; l++)
+    {
+        // One Euclid step first: once the running gcd is small, b % a is tiny and
+        // the Stein steps below finish almost immediately. Put the zero (if any)
+        // in y so x is never 0 while y is not
+        unsigned a = acc[l];
+        unsigned b = (unsigned)vals[l];
+        x[l] = a == 0 ? b : a;
+        y[l] = a == 0 ? 0 : b % a;
+        k[l] = 0;
+        any |= y[l];
+    }
+
+    while (any != 0)
+    {
+        any = 0;
+#pragma omp simd reduction(| : any)
+        for (int l = 0; l < GCD_LANES; l++)
+        {
+            unsigned xv = x[l];
+            unsigned yv = y[l];
+            unsigned active = yv != 0;
+            unsigned x_even = (xv & 1) == 0;
+            unsigned y_even = (yv & 1) == 0;
+            unsigned both_odd = active & !x_even & !y_even;
+            unsigned lo = xv < yv ? xv : yv;
+            unsigned hi = xv < yv ? yv : xv;
+
+            k[l] += active & x_even & y_even;
+            xv = (active & x_even) ? xv >> 1 : xv;
+            yv = (active & y_even) ? yv >> 1 : yv;
+            x[l] = both_odd ? lo : xv;
+            y[l] = both_odd ? hi - lo : yv;
+            any |= y[l];
+        }
+    }
+
+#pragma omp simd
+    for (int l = 0; l < GCD_LANES; l++)
+    {
+        acc[l] = x[l] << k[l];
+    }
+}
+
+int gcd_reduce_batch(const int vals[], long len, int start)
+{
+    unsigned acc[GCD_LANES] = {0};
+    acc[0] = (unsigned)start;
+
+    long i = 0;
+    for (; i + GCD_LANES <= len; i += GCD_LANES)
+    {
+        gcd_lanes(acc, vals + i);
+
+        // The overall gcd divides every lane, so a lane at 1 means we are done
+        unsigned one = 0;
+        for (int l = 0; l < GCD_LANES; l++)
+        {
+            one |= acc[l] == 1;
+        }
+        if (one)
+        {
+            return 1;
+        }
+    }
+
+    // Combine the lanes, then finish off the elements that did not fill a batch
+    int result = 0;
+    for (int l = 0; l < GCD_LANES; l++)
+    {
+        result = gcd_binary(result, (int)acc[l]);
+    }
+    for (; i < len && result != 1; i++)
+    {
+        result = gcd_binary(result, vals[i]);
+    }
+
+    return result;
+}
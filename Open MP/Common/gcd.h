@@ -0,0 +1,32 @@
+#ifndef GCD_H
+#define GCD_H
+
+// Number of lanes the batched gcd works on at once. 16 fills an AVX-512
+// register of 32 bit ints, 8 fills an AVX2 register
+#ifdef __AVX512F__
+#define GCD_LANES 16
+#else
+#define GCD_LANES 8
+#endif
+
+// int gcd_loop() -> The original gcd, counts down from min(a, b) until it finds a common divisor.
+//  O(min(a, b)) per call, only kept so the benchmark can compare against it
+int gcd_loop(int a, int b);
+
+// int gcd_binary() -> Binary (Stein) gcd of two non negative integers, O(log(max(a, b)))
+int gcd_binary(int a, int b);
+
+// int gcd() -> The gcd used by the reduction engine: one Euclid step followed by the binary gcd
+int gcd(int a, int b);
+
+// int gcd_reduce_batch() -> Reduces an array of non negative integers with gcd, GCD_LANES
+//  elements at a time, in a form the compiler can vectorize. Stops as soon as the running
+//  gcd reaches 1, since nothing can change it after that
+//
+// INPUTS
+//  - const int vals[] -> The values to reduce
+//  - long len -> The length of the value array
+//  - int start -> The running gcd to continue from (0 to start fresh)
+int gcd_reduce_batch(const int vals[], long len, int start);
+
+#endif
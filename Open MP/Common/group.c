@@ -0,0 +1,404 @@
+#include "group.h"
+
+#include <omp.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// group_table -> An open addressing hash table with linear probing from keys to partial results
+typedef struct
+{
+    int *keys;
+    int *vals;
+    unsigned char *used;
+    long capacity;
+    long size;
+} group_table;
+
+// A multiplicative hash. The top bits pick a table or partition, the bits below them a slot
+static inline uint64_t group_hash(int key)
+{
+    return (uint64_t)(uint32_t)key * 0x9E3779B97F4A7C15ull;
+}
+
+static inline long hash_slot(uint64_t h, long capacity)
+{
+    return (long)(h >> 20) & (capacity - 1);
+}
+
+// Which of n parts a hash belongs to, from its top 16 bits
+static inline int hash_part(uint64_t h, int n)
+{
+    return (int)(((h >> 48) * (uint64_t)n) >> 16);
+}
+
+static void table_init(group_table *t, long capacity)
+{
+    t->capacity = capacity;
+    t->size = 0;
+    t->keys = malloc(capacity * sizeof(int));
+    t->vals = malloc(capacity * sizeof(int));
+    t->used = calloc(capacity, 1);
+}
+
+static void table_free(group_table *t)
+{
+    free(t->keys);
+    free(t->vals);
+    free(t->used);
+}
+
+// Empties the table, keeping its capacity
+static void table_clear(group_table *t)
+{
+    memset(t->used, 0, t->capacity);
+    t->size = 0;
+}
+
+static void table_insert(group_table *t, const reduce_operator *op, int key, int val);
+
+// Doubles the capacity, so the table stays at most half full
+static void table_grow(group_table *t, const reduce_operator *op)
+{
+    group_table old = *t;
+    table_init(t, old.capacity * 2);
+    for (long i = 0; i < old.capacity; i++)
+    {
+        if (old.used[i])
+        {
+            table_insert(t, op, old.keys[i], old.vals[i]);
+        }
+    }
+    table_free(&old);
+}
+
+static void table_insert(group_table *t, const reduce_operator *op, int key, int val)
+{
+    long mask = t->capacity - 1;
+    for (long slot = hash_slot(group_hash(key), t->capacity);; slot = (slot + 1) & mask)
+    {
+        if (!t->used[slot])
+        {
+            t->used[slot] = 1;
+            t->keys[slot] = key;
+            t->vals[slot] = val;
+            if (++t->size * 2 > t->capacity)
+            {
+                table_grow(t, op);
+            }
+            return;
+        }
+        if (t->keys[slot] == key)
+        {
+            t->vals[slot] = op->func(t->vals[slot], val);
+            return;
+        }
+    }
+}
+
+// Appends the entries of t to keys and vals and returns how many there were
+static long table_drain(const group_table *t, int keys[], int vals[])
+{
+    long n = 0;
+    for (long i = 0; i < t->capacity; i++)
+    {
+        if (t->used[i])
+        {
+            keys[n] = t->keys[i];
+            vals[n] = t->vals[i];
+            n++;
+        }
+    }
+    return n;
+}
+
+// The smallest power of 2 that is at least n
+static long next_pow2(long n)
+{
+    long p = 1;
+    while (p < n)
+    {
+        p *= 2;
+    }
+    return p;
+}
+
+// Copies every part's groups, counts[p] of them starting at from_keys/vals + starts[p], to one
+// contiguous result, in part order
+static group_result gather(const int from_keys[], const int from_vals[], const long starts[], const long counts[],
+                           int n_parts, int n_threads)
+{
+    long *offsets = malloc((n_parts + 1) * sizeof(long));
+    offsets[0] = 0;
+    for (int p = 0; p < n_parts; p++)
+    {
+        offsets[p + 1] = offsets[p] + counts[p];
+    }
+
+    group_result result;
+    result.n_groups = offsets[n_parts];
+    result.keys = malloc((result.n_groups > 0 ? result.n_groups : 1) * sizeof(int));
+    result.values = malloc((result.n_groups > 0 ? result.n_groups : 1) * sizeof(int));
+
+#pragma omp parallel for schedule(dynamic, 1) num_threads(n_threads)
+    for (int p = 0; p < n_parts; p++)
+    {
+        memcpy(result.keys + offsets[p], from_keys + starts[p], counts[p] * sizeof(int));
+        memcpy(result.values + offsets[p], from_vals + starts[p], counts[p] * sizeof(int));
+    }
+
+    free(offsets);
+    return result;
+}
+
+static group_result group_hash_tables(const reduce_operator *op, const int keys[], const int vals[], long len,
+                                      int n_threads)
+{
+    // tables[t * team + p] holds the keys of thread t's block that belong to part p. The runtime
+    // can grant fewer threads than asked for, so everything is sized by the team it does grant
+    group_table *tables = NULL;
+    group_table *merged = NULL;
+    long *starts = NULL;
+    long *counts = NULL;
+    int *out_keys = NULL;
+    int *out_vals = NULL;
+    int team = 1;
+
+#pragma omp parallel num_threads(n_threads)
+    {
+        int tid = omp_get_thread_num();
+#pragma omp single
+        {
+            team = omp_get_num_threads();
+            tables = malloc((size_t)team * team * sizeof(group_table));
+            merged = malloc(team * sizeof(group_table));
+            starts = malloc(team * sizeof(long));
+            counts = malloc(team * sizeof(long));
+        }
+        long begin = len * tid / team;
+        long end = len * (tid + 1) / team;
+        group_table *mine = tables + (size_t)tid * team;
+
+        for (int p = 0; p < team; p++)
+        {
+            table_init(&mine[p], 1024);
+        }
+        for (long i = begin; i < end; i++)
+        {
+            int key = keys[i];
+            table_insert(&mine[hash_part(group_hash(key), team)], op, key, vals[i]);
+        }
+#pragma omp barrier
+
+        // Merge part tid of every thread, in thread order, into a table that starts as big as the
+        // largest of them
+        long largest = 0;
+        for (int t = 0; t < team; t++)
+        {
+            long size = tables[(size_t)t * team + tid].size;
+            largest = size > largest ? size : largest;
+        }
+        table_init(&merged[tid], next_pow2(2 * largest + 2));
+        for (int t = 0; t < team; t++)
+        {
+            group_table *part = &tables[(size_t)t * team + tid];
+            for (long i = 0; i < part->capacity; i++)
+            {
+                if (part->used[i])
+                {
+                    table_insert(&merged[tid], op, part->keys[i], part->vals[i]);
+                }
+            }
+        }
+#pragma omp barrier
+
+        // Nothing reads the per thread tables any more
+        for (int p = 0; p < team; p++)
+        {
+            table_free(&mine[p]);
+        }
+#pragma omp single
+        {
+            long total = 0;
+            for (int t = 0; t < team; t++)
+            {
+                starts[t] = total;
+                total += merged[t].size;
+            }
+            out_keys = malloc((total > 0 ? total : 1) * sizeof(int));
+            out_vals = malloc((total > 0 ? total : 1) * sizeof(int));
+        }
+
+        counts[tid] = table_drain(&merged[tid], out_keys + starts[tid], out_vals + starts[tid]);
+        table_free(&merged[tid]);
+    }
+
+    group_result result = {out_keys, out_vals, 0};
+    for (int t = 0; t < team; t++)
+    {
+        result.n_groups += counts[t];
+    }
+
+    free(tables);
+    free(merged);
+    free(starts);
+    free(counts);
+    return result;
+}
+
+static group_result group_partitions(const reduce_operator *op, const int keys[], const int vals[], long len,
+                                     int n_threads)
+{
+    int n_parts = (int)next_pow2(len / GROUP_PARTITION_LEN + 1);
+    n_parts = n_parts < 4 * n_threads ? (int)next_pow2(4 * n_threads) : n_parts;
+    n_parts = n_parts > 65536 ? 65536 : n_parts;
+
+    int *part_keys = malloc((len > 0 ? len : 1) * sizeof(int));
+    int *part_vals = malloc((len > 0 ? len : 1) * sizeof(int));
+    long *starts = malloc((n_parts + 1) * sizeof(long));
+    long *counts = malloc(n_parts * sizeof(long));
+    // positions[t * n_parts + p] is where thread t writes its next pair of part p, for every
+    // thread of the team the runtime actually grants
+    long *positions = NULL;
+    int team = 1;
+
+#pragma omp parallel num_threads(n_threads)
+    {
+        int tid = omp_get_thread_num();
+#pragma omp single
+        {
+            team = omp_get_num_threads();
+            positions = malloc((size_t)team * n_parts * sizeof(long));
+        }
+        long begin = len * tid / team;
+        long end = len * (tid + 1) / team;
+        long *mine = positions + (size_t)tid * n_parts;
+
+        // Count, scan and scatter the pairs into partitions, as one radix sort pass does
+        memset(mine, 0, n_parts * sizeof(long));
+        for (long i = begin; i < end; i++)
+        {
+            mine[hash_part(group_hash(keys[i]), n_parts)]++;
+        }
+#pragma omp barrier
+#pragma omp single
+        {
+            long offset = 0;
+            for (int p = 0; p < n_parts; p++)
+            {
+                starts[p] = offset;
+                for (int t = 0; t < team; t++)
+                {
+                    long count = positions[(size_t)t * n_parts + p];
+                    positions[(size_t)t * n_parts + p] = offset;
+                    offset += count;
+                }
+            }
+            starts[n_parts] = offset;
+        }
+        for (long i = begin; i < end; i++)
+        {
+            long at = mine[hash_part(group_hash(keys[i]), n_parts)]++;
+            part_keys[at] = keys[i];
+            part_vals[at] = vals[i];
+        }
+#pragma omp barrier
+
+        // Reduce every partition with one reused table, and write its groups back over its pairs.
+        // The table grows to the most groups any of this thread's partitions has, not to the
+        // number of pairs, since a few keys repeated many times can fill a partition
+        group_table table;
+        table_init(&table, 1024);
+#pragma omp for schedule(dynamic, 1)
+        for (int p = 0; p < n_parts; p++)
+        {
+            table_clear(&table);
+            for (long i = starts[p]; i < starts[p + 1]; i++)
+            {
+                table_insert(&table, op, part_keys[i], part_vals[i]);
+            }
+            counts[p] = table_drain(&table, part_keys + starts[p], part_vals + starts[p]);
+        }
+        table_free(&table);
+    }
+
+    group_result result = gather(part_keys, part_vals, starts, counts, n_parts, n_threads);
+
+    free(part_keys);
+    free(part_vals);
+    free(positions);
+    free(starts);
+    free(counts);
+    return result;
+}
+
+group_strategy group_choose(const int keys[], long len)
+{
+    long n = len < GROUP_SAMPLE_LEN ? len : GROUP_SAMPLE_LEN;
+    if (n == 0)
+    {
+        return GROUP_HASH;
+    }
+
+    // Count the distinct keys of an evenly spaced sample, stopping once there are enough
+    long capacity = next_pow2(2 * GROUP_SAMPLE_LEN);
+    int *seen = malloc(capacity * sizeof(int));
+    unsigned char *used = calloc(capacity, 1);
+    long distinct = 0;
+    for (long s = 0; s < n && distinct <= GROUP_HIGH_CARDINALITY; s++)
+    {
+        int key = keys[(long)((double)len * s / n)];
+        long slot = hash_slot(group_hash(key), capacity);
+        while (used[slot] && seen[slot] != key)
+        {
+            slot = (slot + 1) & (capacity - 1);
+        }
+        if (!used[slot])
+        {
+            used[slot] = 1;
+            seen[slot] = key;
+            distinct++;
+        }
+    }
+    free(seen);
+    free(used);
+
+    return distinct > GROUP_HIGH_CARDINALITY ? GROUP_PARTITION : GROUP_HASH;
+}
+
+group_result group_reduce(const reduce_operator *op, const int keys[], const int vals[], long len,
+                          group_strategy strategy, int n_threads)
+{
+    if (strategy == GROUP_AUTO)
+    {
+        strategy = group_choose(keys, len);
+    }
+    if (strategy == GROUP_PARTITION)
+    {
+        return group_partitions(op, keys, vals, len, n_threads);
+    }
+    return group_hash_tables(op, keys, vals, len, n_threads);
+}
+
+const char *group_name(group_strategy strategy)
+{
+    switch (strategy)
+    {
+    case GROUP_HASH:
+        return "hash";
+    case GROUP_PARTITION:
+        return "partition";
+    default:
+        return "auto";
+    }
+}
+
+void group_free(group_result *result)
+{
+    free(result->keys);
+    free(result->values);
+    result->keys = NULL;
+    result->values = NULL;
+    result->n_groups = 0;
+}
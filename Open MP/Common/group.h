@@ -0,0 +1,67 @@
+#ifndef GROUP_H
+#define GROUP_H
+
+#include "reduction.h"
+
+// Above this many distinct keys in a sample of GROUP_SAMPLE_LEN keys, group_reduce() treats the
+// keys as high cardinality and partitions them instead of hashing them per thread
+#define GROUP_SAMPLE_LEN 16384
+#define GROUP_HIGH_CARDINALITY (GROUP_SAMPLE_LEN / 4)
+
+// The number of pairs the partitioned strategy aims to put in each partition, so that a
+// partition and its hash table fit in L2
+#define GROUP_PARTITION_LEN 16384
+
+// How group_reduce() builds the groups
+//  - GROUP_HASH -> Every thread reduces its own block into its own open addressing hash tables,
+//      one per thread, split by key hash. Thread t then merges table t of every thread, so the
+//      merge runs in parallel without locks. Best when the groups fit in cache
+//  - GROUP_PARTITION -> The pairs are first scattered into many small partitions by key hash (one
+//      radix sort pass), then the partitions are reduced independently, each with a hash table
+//      that fits in cache. Best when there are too many groups for per thread tables to stay in
+//      cache, where GROUP_HASH misses on nearly every insert and merges tables as big as the input
+//  - GROUP_AUTO -> GROUP_PARTITION if a sample of the keys is mostly distinct, GROUP_HASH otherwise
+typedef enum
+{
+    GROUP_HASH,
+    GROUP_PARTITION,
+    GROUP_AUTO
+} group_strategy;
+
+// group_result -> The reduction of every distinct key, in no particular order
+//
+// FIELDS
+//  - int* keys -> The distinct keys
+//  - int* values -> values[i] is the reduction of every value whose key is keys[i]
+//  - long n_groups -> The number of distinct keys
+typedef struct
+{
+    int *keys;
+    int *values;
+    long n_groups;
+} group_result;
+
+// group_result group_reduce() -> Reduces vals grouped by keys: the values of every key are
+//  combined with op in input order. The first value of a key starts its group, so the operator's
+//  identity is never used
+//
+// INPUTS
+//  - const reduce_operator* op -> The operator to reduce with (see reduction.h)
+//  - const int keys[] -> The key of each value
+//  - const int vals[] -> The values to reduce
+//  - long len -> The length of the key and value arrays
+//  - group_strategy strategy -> How to build the groups
+//  - int n_threads -> The number of threads to use
+group_result group_reduce(const reduce_operator *op, const int keys[], const int vals[], long len,
+                          group_strategy strategy, int n_threads);
+
+// group_strategy group_choose() -> The strategy GROUP_AUTO picks for these keys
+group_strategy group_choose(const int keys[], long len);
+
+// const char* group_name() -> The name of a strategy ("hash", "partition" or "auto")
+const char *group_name(group_strategy strategy);
+
+// void group_free() -> Frees the arrays of a result
+void group_free(group_result *result);
+
+#endif
@@ -0,0 +1,170 @@
+#include "locks.h"
+
+#include <sched.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+// backoff -> Waits a little before the next look at the lock: a pause hint for the first
+//  LOCK_SPINS_BEFORE_YIELD tries, then giving the CPU to another thread
+typedef struct
+{
+    int spins;
+} backoff;
+
+static void backoff_wait(backoff *b)
+{
+    if (b->spins++ < LOCK_SPINS_BEFORE_YIELD)
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        _mm_pause();
+#elif defined(__aarch64__)
+        __asm__ volatile("yield");
+#endif
+        return;
+    }
+    sched_yield();
+}
+
+void tas_init(tas_lock *l)
+{
+    atomic_init(&l->held, false);
+}
+
+void tas_acquire(tas_lock *l)
+{
+    backoff b = {0};
+    while (atomic_exchange_explicit(&l->held, true, memory_order_acquire))
+    {
+        while (atomic_load_explicit(&l->held, memory_order_relaxed))
+        {
+            backoff_wait(&b);
+        }
+    }
+}
+
+void tas_release(tas_lock *l)
+{
+    atomic_store_explicit(&l->held, false, memory_order_release);
+}
+
+void ticket_init(ticket_lock *l)
+{
+    atomic_init(&l->next, 0);
+    atomic_init(&l->serving, 0);
+}
+
+void ticket_acquire(ticket_lock *l)
+{
+    unsigned ticket = atomic_fetch_add_explicit(&l->next, 1, memory_order_relaxed);
+    backoff b = {0};
+    while (atomic_load_explicit(&l->serving, memory_order_acquire) != ticket)
+    {
+        backoff_wait(&b);
+    }
+}
+
+void ticket_release(ticket_lock *l)
+{
+    // Only the holder writes serving, so a plain load and store is enough
+    unsigned serving = atomic_load_explicit(&l->serving, memory_order_relaxed);
+    atomic_store_explicit(&l->serving, serving + 1, memory_order_release);
+}
+
+void mcs_init(mcs_lock *l)
+{
+    atomic_init(&l->tail, NULL);
+}
+
+void mcs_acquire(mcs_lock *l, mcs_node *node)
+{
+    atomic_store_explicit(&node->next, NULL, memory_order_relaxed);
+    atomic_store_explicit(&node->waiting, true, memory_order_relaxed);
+
+    mcs_node *prev = atomic_exchange_explicit(&l->tail, node, memory_order_acq_rel);
+    if (prev == NULL)
+    {
+        return;
+    }
+
+    // Join the queue behind prev and wait for it to hand the lock over
+    atomic_store_explicit(&prev->next, node, memory_order_release);
+    backoff b = {0};
+    while (atomic_load_explicit(&node->waiting, memory_order_acquire))
+    {
+        backoff_wait(&b);
+    }
+}
+
+void mcs_release(mcs_lock *l, mcs_node *node)
+{
+    mcs_node *next = atomic_load_explicit(&node->next, memory_order_acquire);
+    if (next == NULL)
+    {
+        // No one queued: empty the queue, unless someone is joining right now
+        mcs_node *expected = node;
+        if (atomic_compare_exchange_strong_explicit(&l->tail, &expected, NULL, memory_order_release,
+                                                    memory_order_relaxed))
+        {
+            return;
+        }
+
+        // They swapped the tail but have not linked in yet
+        backoff b = {0};
+        while ((next = atomic_load_explicit(&node->next, memory_order_acquire)) == NULL)
+        {
+            backoff_wait(&b);
+        }
+    }
+    atomic_store_explicit(&next->waiting, false, memory_order_release);
+}
+
+void rw_init(rw_lock *l)
+{
+    atomic_init(&l->readers, 0);
+    atomic_init(&l->writers, 0);
+}
+
+void rw_acquire_read(rw_lock *l)
+{
+    backoff b = {0};
+    for (;;)
+    {
+        // Stay out while a writer is waiting, then get in unless one got in first
+        while (atomic_load_explicit(&l->writers, memory_order_relaxed) > 0)
+        {
+            backoff_wait(&b);
+        }
+        int readers = atomic_load_explicit(&l->readers, memory_order_relaxed);
+        if (readers >= 0 && atomic_compare_exchange_weak_explicit(&l->readers, &readers, readers + 1,
+                                                                  memory_order_acquire, memory_order_relaxed))
+        {
+            return;
+        }
+        backoff_wait(&b);
+    }
+}
+
+void rw_release_read(rw_lock *l)
+{
+    atomic_fetch_sub_explicit(&l->readers, 1, memory_order_release);
+}
+
+void rw_acquire_write(rw_lock *l)
+{
+    atomic_fetch_add_explicit(&l->writers, 1, memory_order_relaxed);
+    backoff b = {0};
+    int free = 0;
+    while (!atomic_compare_exchange_weak_explicit(&l->readers, &free, -1, memory_order_acquire, memory_order_relaxed))
+    {
+        free = 0;
+        backoff_wait(&b);
+    }
+}
+
+void rw_release_write(rw_lock *l)
+{
+    atomic_store_explicit(&l->readers, 0, memory_order_release);
+    atomic_fetch_sub_explicit(&l->writers, 1, memory_order_relaxed);
+}
@@ -0,0 +1,78 @@
+#ifndef LOCKS_H
+#define LOCKS_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+
+#include "padded.h"
+
+// Spin locks to compare against #pragma omp critical and omp_lock_t. Every one spins on a load
+// with a CPU pause hint and yields the CPU after LOCK_SPINS_BEFORE_YIELD tries, so a run with more
+// threads than cores still finishes when the thread next in line has been descheduled
+
+// How many times a waiter spins before yielding the CPU
+#define LOCK_SPINS_BEFORE_YIELD 1024
+
+// tas_lock -> A test and test and set lock: waiters spin reading the flag and only try to set it
+//  once it looks free, so they do not bounce the cache line while it is held
+typedef struct
+{
+    _Alignas(CACHE_LINE_SIZE) atomic_bool held;
+} tas_lock;
+
+// ticket_lock -> A first come first served lock: each thread takes a ticket and waits until it is
+//  served. The two counters are on separate cache lines so taking a ticket does not disturb the
+//  waiters spinning on serving
+typedef struct
+{
+    _Alignas(CACHE_LINE_SIZE) atomic_uint next;
+    _Alignas(CACHE_LINE_SIZE) atomic_uint serving;
+} ticket_lock;
+
+// mcs_node -> One thread's place in the queue of an mcs_lock. Each thread brings its own node,
+//  and must not reuse it until it has released the lock
+typedef struct mcs_node
+{
+    _Alignas(CACHE_LINE_SIZE) struct mcs_node *_Atomic next;
+    atomic_bool waiting;
+} mcs_node;
+
+// mcs_lock -> The Mellor-Crummey and Scott queue lock: waiters form a linked list and each spins
+//  on a flag in its own node, so a release touches only the next waiter's cache line
+typedef struct
+{
+    _Alignas(CACHE_LINE_SIZE) mcs_node *_Atomic tail;
+} mcs_lock;
+
+// rw_lock -> A reader writer lock that lets any number of readers or one writer in. Writers
+//  announce themselves first and new readers stay out until they are done, so a steady stream of
+//  readers cannot starve a writer
+//
+// FIELDS
+//  - atomic_int readers -> The number of readers inside, or -1 while a writer is inside
+//  - atomic_int writers -> The number of writers waiting or inside
+typedef struct
+{
+    _Alignas(CACHE_LINE_SIZE) atomic_int readers;
+    atomic_int writers;
+} rw_lock;
+
+void tas_init(tas_lock *l);
+void tas_acquire(tas_lock *l);
+void tas_release(tas_lock *l);
+
+void ticket_init(ticket_lock *l);
+void ticket_acquire(ticket_lock *l);
+void ticket_release(ticket_lock *l);
+
+void mcs_init(mcs_lock *l);
+void mcs_acquire(mcs_lock *l, mcs_node *node);
+void mcs_release(mcs_lock *l, mcs_node *node);
+
+void rw_init(rw_lock *l);
+void rw_acquire_read(rw_lock *l);
+void rw_release_read(rw_lock *l);
+void rw_acquire_write(rw_lock *l);
+void rw_release_write(rw_lock *l);
+
+#endif
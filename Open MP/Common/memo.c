@@ -0,0 +1,237 @@
+#include "memo.h"
+
+#include <omp.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *memo_names[] = {"off", "table", "cache", "auto"};
+
+bool memo_parse(const char *name, memo_mode *mode)
+{
+    for (int i = 0; i <= MEMO_AUTO; i++)
+    {
+        if (strcmp(name, memo_names[i]) == 0)
+        {
+            *mode = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char *memo_name(memo_mode mode)
+{
+    return memo_names[mode];
+}
+
+static inline uint64_t memo_hash(int x)
+{
+    return ((uint64_t)(uint32_t)x * 0x9E3779B97F4A7C15ull) >> 20;
+}
+
+// The smallest power of 2 that is at least n
+static long next_pow2(long n)
+{
+    long p = 1;
+    while (p < n)
+    {
+        p *= 2;
+    }
+    return p;
+}
+
+// Sets *min_val and *max_val to the range of vals, in parallel
+static void value_range(const int vals[], long len, int n_threads, int *min_val, int *max_val)
+{
+    int lo = 0x7fffffff;
+    int hi = -0x7fffffff - 1;
+#pragma omp parallel for schedule(static) num_threads(n_threads) reduction(min : lo) reduction(max : hi)
+    for (long i = 0; i < len; i++)
+    {
+        lo = vals[i] < lo ? vals[i] : lo;
+        hi = vals[i] > hi ? vals[i] : hi;
+    }
+    *min_val = lo;
+    *max_val = hi;
+}
+
+memo_mode memo_choose(int (*func)(int x), const int vals[], long len, int n_threads)
+{
+    long n = len < MEMO_SAMPLE_LEN ? len : MEMO_SAMPLE_LEN;
+    if (n == 0)
+    {
+        return MEMO_OFF;
+    }
+
+    // Time the function on an evenly spaced sample, since its cost may depend on the value. The
+    // sample is gathered first so the timing is of the calls and not of cache misses in vals.
+    // The results go into a volatile sink so the calls are not optimised away
+    int *sample = malloc(n * sizeof(int));
+    for (long s = 0; s < n; s++)
+    {
+        sample[s] = vals[(long)((double)len * s / n)];
+    }
+    volatile int sink = 0;
+    double start = omp_get_wtime();
+    for (long s = 0; s < n; s++)
+    {
+        sink += func(sample[s]);
+    }
+    if ((omp_get_wtime() - start) / n < MEMO_MIN_COST)
+    {
+        free(sample);
+        return MEMO_OFF;
+    }
+
+    int min_val;
+    int max_val;
+    value_range(vals, len, n_threads, &min_val, &max_val);
+    long range = (long)max_val - min_val + 1;
+    if (range <= MEMO_TABLE_MAX && range <= len / MEMO_MIN_REUSE)
+    {
+        free(sample);
+        return MEMO_TABLE;
+    }
+
+    // Count the distinct values of the sample
+    long capacity = next_pow2(2 * MEMO_SAMPLE_LEN);
+    int *seen = malloc(capacity * sizeof(int));
+    unsigned char *used = calloc(capacity, 1);
+    long distinct = 0;
+    for (long s = 0; s < n; s++)
+    {
+        int x = sample[s];
+        long slot = memo_hash(x) & (capacity - 1);
+        while (used[slot] && seen[slot] != x)
+        {
+            slot = (slot + 1) & (capacity - 1);
+        }
+        if (!used[slot])
+        {
+            used[slot] = 1;
+            seen[slot] = x;
+            distinct++;
+        }
+    }
+    free(seen);
+    free(used);
+    free(sample);
+
+    return distinct * MEMO_MIN_REUSE <= n ? MEMO_CACHE : MEMO_OFF;
+}
+
+// Builds the dense table: marks which values occur, then computes each of them once
+static void build_table(memo *m, const int vals[], long len, int n_threads)
+{
+    int max_val;
+    value_range(vals, len, n_threads, &m->min_val, &max_val);
+    long range = len > 0 ? (long)max_val - m->min_val + 1 : 1;
+    m->table = malloc(range * sizeof(int));
+    unsigned char *present = calloc(range, 1);
+
+    // Every thread writing the same 1 is the only conflict, so the stores only need to be atomic
+#pragma omp parallel for schedule(static) num_threads(n_threads)
+    for (long i = 0; i < len; i++)
+    {
+#pragma omp atomic write
+        present[vals[i] - m->min_val] = 1;
+    }
+
+    // The cost of the function can grow with the value, so the values are handed out dynamically
+    long calls = 0;
+#pragma omp parallel for schedule(dynamic, 64) num_threads(n_threads) reduction(+ : calls)
+    for (long v = 0; v < range; v++)
+    {
+        if (present[v])
+        {
+            m->table[v] = m->func((int)(v + m->min_val));
+            calls++;
+        }
+    }
+    atomic_store(&m->calls, calls);
+    free(present);
+}
+
+void memo_create(memo *m, memo_mode mode, int (*func)(int x), const int vals[], long len, int n_threads)
+{
+    m->func = func;
+    m->min_val = 0;
+    m->table = NULL;
+    m->cache = NULL;
+    m->cache_mask = 0;
+    atomic_init(&m->calls, 0);
+    m->mode = mode == MEMO_AUTO ? memo_choose(func, vals, len, n_threads) : mode;
+
+    if (m->mode == MEMO_TABLE)
+    {
+        build_table(m, vals, len, n_threads);
+    }
+    else if (m->mode == MEMO_CACHE)
+    {
+        long capacity = next_pow2(2 * (len > 0 ? len : 1));
+        capacity = capacity > MEMO_CACHE_MAX ? MEMO_CACHE_MAX : capacity;
+        m->cache = malloc(capacity * sizeof(*m->cache));
+        m->cache_mask = capacity - 1;
+#pragma omp parallel for schedule(static) num_threads(n_threads)
+        for (long i = 0; i < capacity; i++)
+        {
+            atomic_init(&m->cache[i], MEMO_EMPTY);
+        }
+    }
+}
+
+int memo_cache_get(memo *m, int x)
+{
+    // The key and result share one 64 bit word, so a slot is always read whole and never torn
+    long slot = memo_hash(x) & m->cache_mask;
+    for (int probe = 0; probe < MEMO_PROBES; probe++)
+    {
+        uint64_t entry = atomic_load_explicit(&m->cache[slot], memory_order_relaxed);
+        if (entry == MEMO_EMPTY)
+        {
+            int result = m->func(x);
+            atomic_fetch_add_explicit(&m->calls, 1, memory_order_relaxed);
+            // Losing the race to another thread storing the same slot just leaves this result uncached
+            uint64_t expected = MEMO_EMPTY;
+            uint64_t mine = (uint64_t)(uint32_t)x << 32 | (uint32_t)result;
+            atomic_compare_exchange_strong_explicit(&m->cache[slot], &expected, mine, memory_order_relaxed,
+                                                    memory_order_relaxed);
+            return result;
+        }
+        if ((int)(uint32_t)(entry >> 32) == x)
+        {
+            return (int)(uint32_t)entry;
+        }
+        slot = (slot + 1) & m->cache_mask;
+    }
+
+    // Every probed slot holds another value: the cache is too full here, just compute it
+    atomic_fetch_add_explicit(&m->calls, 1, memory_order_relaxed);
+    return m->func(x);
+}
+
+void memo_map(memo *m, const int in[], int out[], long len, int n_threads)
+{
+#pragma omp parallel for schedule(runtime) num_threads(n_threads)
+    for (long i = 0; i < len; i++)
+    {
+        out[i] = memo_get(m, in[i]);
+    }
+}
+
+double memo_hit_rate(memo *m, long lookups)
+{
+    if (m->mode == MEMO_OFF || lookups == 0)
+    {
+        return 0;
+    }
+    return 1.0 - (double)atomic_load(&m->calls) / lookups;
+}
+
+void memo_free(memo *m)
+{
+    free(m->table);
+    free(m->cache);
+    m->table = NULL;
+    m->cache = NULL;
+}
@@ -0,0 +1,124 @@
+#ifndef MEMO_H
+#define MEMO_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// The most values a dense table covers (64MB of results)
+#define MEMO_TABLE_MAX (1 << 24)
+
+// The most entries the concurrent cache holds (32MB)
+#define MEMO_CACHE_MAX (1 << 22)
+
+// How many slots a cache lookup probes before giving up and calling the function
+#define MEMO_PROBES 8
+
+// Memoizing only pays when every distinct value is looked up at least this many times
+#define MEMO_MIN_REUSE 4
+
+// The values memo_choose() samples, and the least time one call of the function has to take
+// for memoizing it to beat calling it (a lookup that misses cache costs about this much)
+#define MEMO_SAMPLE_LEN 4096
+#define MEMO_MIN_COST 2e-8
+
+// A cache slot nothing has been stored in. The one pair it stands for (key -1, result -1) is
+// never cached, only computed
+#define MEMO_EMPTY UINT64_MAX
+
+// How a memo looks results up
+//  - MEMO_OFF -> It does not, every value is passed to the function
+//  - MEMO_TABLE -> A dense array over [min, max] of the input values, with the result of every
+//      value that occurs computed up front in parallel. For small domains
+//  - MEMO_CACHE -> A fixed size open addressing hash table that threads fill concurrently as
+//      they miss, without locks. For domains too wide for a table
+//  - MEMO_AUTO -> Whichever of the above memo_choose() picks for the input
+typedef enum
+{
+    MEMO_OFF,
+    MEMO_TABLE,
+    MEMO_CACHE,
+    MEMO_AUTO
+} memo_mode;
+
+// memo -> Remembered results of a pure int -> int function
+//
+// FIELDS
+//  - memo_mode mode -> How results are looked up, never MEMO_AUTO
+//  - int (*func)(int x) -> The function
+//  - int min_val -> The smallest value the table covers
+//  - int* table -> table[x - min_val] is func(x), for every x in the values the memo was built from
+//  - _Atomic uint64_t* cache -> The cache slots, each a key in the high and a result in the low
+//      32 bits, or MEMO_EMPTY
+//  - long cache_mask -> The number of cache slots minus 1
+//  - atomic_long calls -> How many times a table build or a cache miss has called func
+typedef struct
+{
+    memo_mode mode;
+    int (*func)(int x);
+    int min_val;
+    int *table;
+    _Atomic uint64_t *cache;
+    long cache_mask;
+    atomic_long calls;
+} memo;
+
+// bool memo_parse() -> Reads a mode name ("off", "table", "cache" or "auto")
+bool memo_parse(const char *name, memo_mode *mode);
+
+// const char* memo_name() -> The name of a mode
+const char *memo_name(memo_mode mode);
+
+// memo_mode memo_choose() -> Picks how to memoize func over vals: not at all if one call costs
+//  less than MEMO_MIN_COST, a table if the range of the values is at most MEMO_TABLE_MAX and
+//  len / MEMO_MIN_REUSE, a cache if a sample of the values repeats at least MEMO_MIN_REUSE times
+//  on average, and not at all otherwise
+//
+// INPUTS
+//  - int (*func)(int x) -> The function
+//  - const int vals[] -> The values it will be called on
+//  - long len -> The length of the value array
+//  - int n_threads -> The number of threads to scan the values with
+memo_mode memo_choose(int (*func)(int x), const int vals[], long len, int n_threads);
+
+// void memo_create() -> Sets up a memo for func over vals, building the table in parallel if
+//  the mode is (or memo_choose() picks) MEMO_TABLE
+//
+// INPUTS
+//  - memo* m -> The memo to set up
+//  - memo_mode mode -> How to look results up
+//  - int (*func)(int x) -> The function, which must be pure
+//  - const int vals[] -> The values the memo will be asked about. A table only covers these
+//  - long len -> The length of the value array
+//  - int n_threads -> The number of threads to use
+void memo_create(memo *m, memo_mode mode, int (*func)(int x), const int vals[], long len, int n_threads);
+
+// int memo_cache_get() -> func(x) from the cache, calling func and filling a slot on a miss
+int memo_cache_get(memo *m, int x);
+
+// int memo_get() -> func(x), looked up however the memo does it. With MEMO_TABLE, x has to be
+//  one of the values the memo was built from
+static inline int memo_get(memo *m, int x)
+{
+    switch (m->mode)
+    {
+    case MEMO_TABLE:
+        return m->table[x - m->min_val];
+    case MEMO_CACHE:
+        return memo_cache_get(m, x);
+    default:
+        return m->func(x);
+    }
+}
+
+// void memo_map() -> Sets out[i] = func(in[i]) in parallel through the memo. The loop follows
+//  the schedule set with schedule_apply(), and out may be in
+void memo_map(memo *m, const int in[], int out[], long len, int n_threads);
+
+// double memo_hit_rate() -> The fraction of lookups that did not call the function, 0 for MEMO_OFF
+double memo_hit_rate(memo *m, long lookups);
+
+// void memo_free() -> Frees the table or cache
+void memo_free(memo *m);
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef PADDED_H
+#define PADDED_H
+
+#include <stdlib.h>
+#include <string.h>
+
+// Size of the slot each thread gets. Apple silicon has 128 byte cache lines, and on
+// x86 the adjacent line prefetcher pulls lines in pairs, so either can be forced with
+// -DCACHE_LINE_SIZE=64 or -DCACHE_LINE_SIZE=128
+#ifndef CACHE_LINE_SIZE
+#if defined(__APPLE__) && defined(__aarch64__)
+#define CACHE_LINE_SIZE 128
+#else
+#define CACHE_LINE_SIZE 64
+#endif
+#endif
+
+// padded_long / padded_int / padded_double -> A per thread accumulator that fills a whole
+//  cache line, so threads updating neighbouring slots never write to the same line
+typedef struct
+{
+    _Alignas(CACHE_LINE_SIZE) long value;
+} padded_long;
+
+typedef struct
+{
+    _Alignas(CACHE_LINE_SIZE) int value;
+} padded_int;
+
+typedef struct
+{
+    _Alignas(CACHE_LINE_SIZE) double value;
+} padded_double;
+
+// void* padded_calloc() -> Allocates n zeroed slots of slot_size bytes aligned to a cache line
+//
+// INPUTS
+//  - int n -> The number of slots, usually the number of threads
+//  - size_t slot_size -> sizeof one of the padded types above
+//
+// Free the result with free()
+static inline void *padded_calloc(int n, size_t slot_size)
+{
+    size_t bytes = (n > 0 ? n : 1) * slot_size;
+    void *slots = aligned_alloc(CACHE_LINE_SIZE, bytes);
+    if (slots != NULL)
+    {
+        memset(slots, 0, bytes);
+    }
+    return slots;
+}
+
+#endif
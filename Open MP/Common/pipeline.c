@@ -0,0 +1,330 @@
+#include "pipeline.h"
+#include "padded.h"
+#include "scan.h"
+#include "simd_map.h"
+
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Out of line predicates for the staged run, which calls them on every element
+static bool is_even(int x) { return x % 2 == 0; }
+static bool is_odd(int x) { return x % 2 != 0; }
+static bool is_positive(int x) { return x > 0; }
+
+// In pipeline_filter order
+static const struct
+{
+    const char *name;
+    bool (*func)(int x);
+} predicates[PIPELINE_N_FILTERS] = {
+    {"even", is_even},
+    {"odd", is_odd},
+    {"positive", is_positive},
+};
+
+// int find_filter() -> The pipeline_filter called name, or -1
+static int find_filter(const char *name)
+{
+    for (int f = 0; f < PIPELINE_N_FILTERS; f++)
+    {
+        if (strcmp(predicates[f].name, name) == 0)
+        {
+            return f;
+        }
+    }
+    return -1;
+}
+
+bool (*pipeline_predicate(const char *name))(int x)
+{
+    int f = find_filter(name);
+    return f >= 0 ? predicates[f].func : NULL;
+}
+
+bool pipeline_parse(const char *spec, pipeline *p)
+{
+    p->n_stages = 0;
+    p->reduce = NULL;
+
+    char copy[256];
+    snprintf(copy, sizeof(copy), "%s", spec);
+
+    char *save;
+    for (char *stage = strtok_r(copy, ",", &save); stage != NULL; stage = strtok_r(NULL, ",", &save))
+    {
+        char *name = strchr(stage, ':');
+        // Nothing may follow the reduction
+        if (name == NULL || p->reduce != NULL)
+        {
+            return false;
+        }
+        *name = '\0';
+        name++;
+
+        if (strcmp(stage, "reduce") == 0)
+        {
+            p->reduce = reduce_find(name);
+            if (p->reduce == NULL)
+            {
+                return false;
+            }
+            continue;
+        }
+
+        if (p->n_stages == PIPELINE_MAX_STAGES)
+        {
+            return false;
+        }
+        pipeline_stage *next = &p->stages[p->n_stages];
+        next->map = NULL;
+        next->predicate = NULL;
+        if (strcmp(stage, "map") == 0)
+        {
+            int op = map_op_find(name);
+            if (op < 0)
+            {
+                return false;
+            }
+            next->map = map_op_func(op);
+            next->op = op;
+        }
+        else if (strcmp(stage, "filter") == 0)
+        {
+            int filter = find_filter(name);
+            if (filter < 0)
+            {
+                return false;
+            }
+            next->predicate = predicates[filter].func;
+            next->filter = filter;
+        }
+        else
+        {
+            return false;
+        }
+        p->n_stages++;
+    }
+    return true;
+}
+
+// DEFINE_COMPACT() -> Generates a loop that compacts the survivors of one predicate to the front of
+//  a block, with the test inlined. Every element is written and only the survivors advance kept,
+//  so there is no branch to mispredict
+#define DEFINE_COMPACT(name, test)                         \
+    static inline int compact_##name(int block[], int n)   \
+    {                                                      \
+        int kept = 0;                                      \
+        for (int i = 0; i < n; i++)                        \
+        {                                                  \
+            int x = block[i];                              \
+            block[kept] = x;                               \
+            kept += (test);                                \
+        }                                                  \
+        return kept;                                       \
+    }
+
+DEFINE_COMPACT(even, (x & 1) == 0)
+DEFINE_COMPACT(odd, (x & 1) != 0)
+DEFINE_COMPACT(positive, x > 0)
+
+// int run_stages() -> Carries block[0, n) through every map and filter stage in place and
+//  returns how many elements survived, compacted to the front of the block. Every stage is one
+//  kernel call over the whole block, so no stage makes a call per element
+static int run_stages(const pipeline *p, map_isa isa, int block[], int n)
+{
+    for (int s = 0; s < p->n_stages && n > 0; s++)
+    {
+        const pipeline_stage *stage = &p->stages[s];
+        if (stage->map != NULL)
+        {
+            simd_map_block(stage->op, isa, block, n);
+            continue;
+        }
+
+        switch (stage->filter)
+        {
+        case PIPELINE_EVEN:
+            n = compact_even(block, n);
+            break;
+        case PIPELINE_ODD:
+            n = compact_odd(block, n);
+            break;
+        default:
+            n = compact_positive(block, n);
+            break;
+        }
+    }
+    return n;
+}
+
+int pipeline_run(const pipeline *p, const int vals[], long len, int n_threads)
+{
+    long n_blocks = (len + PIPELINE_BLOCK - 1) / PIPELINE_BLOCK;
+    padded_int *partials = padded_calloc(n_threads, sizeof(padded_int));
+    int n_partials = n_threads;
+    map_isa isa = map_isa_best();
+
+#pragma omp parallel num_threads(n_threads)
+    {
+        int block[PIPELINE_BLOCK];
+        int local = p->reduce->identity;
+
+        // schedule(static) hands every thread one contiguous range of blocks, so combining the
+        // partials in thread order keeps the input order
+#pragma omp for schedule(static)
+        for (long b = 0; b < n_blocks; b++)
+        {
+            long begin = b * PIPELINE_BLOCK;
+            int n = (int)(len - begin < PIPELINE_BLOCK ? len - begin : PIPELINE_BLOCK);
+            memcpy(block, vals + begin, (size_t)n * sizeof(int));
+
+            n = run_stages(p, isa, block, n);
+            local = p->reduce->block(block, n, local);
+        }
+
+        partials[omp_get_thread_num()].value = local;
+#pragma omp single
+        n_partials = omp_get_num_threads();
+    }
+
+    int result = p->reduce->identity;
+    for (int t = 0; t < n_partials; t++)
+    {
+        result = p->reduce->func(result, partials[t].value);
+    }
+    free(partials);
+    return result;
+}
+
+long pipeline_apply(const pipeline *p, int vals[], long len, int n_threads)
+{
+    padded_long *kept = padded_calloc(n_threads, sizeof(padded_long));
+    long *offsets = malloc(n_threads * sizeof(long));
+    int *scratch = NULL;
+    long total = 0;
+    map_isa isa = map_isa_best();
+
+#pragma omp parallel num_threads(n_threads)
+    {
+        int tid = omp_get_thread_num();
+        int n = omp_get_num_threads();
+        long begin = len * tid / n;
+        long end = len * (tid + 1) / n;
+
+        // Each block is small enough to stay in L1 while every stage runs over it in place,
+        // and its survivors never land past where the block started
+        long write = begin;
+        for (long i = begin; i < end; i += PIPELINE_BLOCK)
+        {
+            int count = run_stages(p, isa, vals + i, (int)(end - i < PIPELINE_BLOCK ? end - i : PIPELINE_BLOCK));
+            memmove(vals + write, vals + i, (size_t)count * sizeof(int));
+            write += count;
+        }
+        kept[tid].value = write - begin;
+
+#pragma omp barrier
+#pragma omp single
+        {
+            // Where every range's survivors go. The first range's are already in place
+            for (int t = 0; t < n; t++)
+            {
+                offsets[t] = total;
+                total += kept[t].value;
+            }
+            if (total > kept[0].value)
+            {
+                scratch = malloc((size_t)(total - kept[0].value) * sizeof(int));
+            }
+        }
+
+        // A range's destination can overlap the survivors of the ranges before it, so the
+        // other ranges are copied out first and then copied back behind the first one
+        long first = kept[0].value;
+        if (tid > 0)
+        {
+            memcpy(scratch + offsets[tid] - first, vals + begin, (size_t)kept[tid].value * sizeof(int));
+        }
+#pragma omp barrier
+#pragma omp for schedule(static)
+        for (long i = first; i < total; i++)
+        {
+            vals[i] = scratch[i - first];
+        }
+    }
+
+    free(scratch);
+    free(offsets);
+    free(kept);
+    return total;
+}
+
+int pipeline_run_staged(const pipeline *p, const int vals[], long len, int n_threads)
+{
+    // The input is left alone, so the first stage works on a copy
+    int *current = malloc((size_t)(len > 0 ? len : 1) * sizeof(int));
+#pragma omp parallel for schedule(static) num_threads(n_threads)
+    for (long i = 0; i < len; i++)
+    {
+        current[i] = vals[i];
+    }
+
+    for (int s = 0; s < p->n_stages; s++)
+    {
+        const pipeline_stage *stage = &p->stages[s];
+        if (stage->map != NULL)
+        {
+#pragma omp parallel for schedule(static) num_threads(n_threads)
+            for (long i = 0; i < len; i++)
+            {
+                current[i] = stage->map(current[i]);
+            }
+            continue;
+        }
+
+        // Two pass filter into a new array, like parallel_filter() in filter.c
+        int *counts = calloc(n_threads, sizeof(int));
+        long *offsets = malloc(n_threads * sizeof(long));
+#pragma omp parallel num_threads(n_threads)
+        {
+            int local_count = 0;
+#pragma omp for schedule(static)
+            for (long i = 0; i < len; i++)
+            {
+                if (stage->predicate(current[i]))
+                {
+                    local_count++;
+                }
+            }
+            counts[omp_get_thread_num()] = local_count;
+        }
+
+        long next_len = exclusive_scan(counts, offsets, n_threads, SCAN_SERIAL, 1);
+        int *next = malloc((size_t)(next_len > 0 ? next_len : 1) * sizeof(int));
+
+#pragma omp parallel num_threads(n_threads)
+        {
+            long pos = offsets[omp_get_thread_num()];
+#pragma omp for schedule(static)
+            for (long i = 0; i < len; i++)
+            {
+                if (stage->predicate(current[i]))
+                {
+                    next[pos] = current[i];
+                    pos++;
+                }
+            }
+        }
+
+        free(counts);
+        free(offsets);
+        free(current);
+        current = next;
+        len = next_len;
+    }
+
+    int result = reduce_run(p->reduce, current, (int)len, n_threads);
+    free(current);
+    return result;
+}
@@ -0,0 +1,108 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <stdbool.h>
+
+#include "reduction.h"
+#include "simd_map.h"
+
+// The most map and filter stages one pipeline can hold
+#define PIPELINE_MAX_STAGES 8
+
+// The number of elements a fused pipeline carries through all of its stages at once.
+// 1024 ints is 4KB, so a block stays in L1 from the first stage to the reduction
+#define PIPELINE_BLOCK 1024
+
+// pipeline_filter -> The predicates a filter stage can use, each with its own compaction loop
+//  - PIPELINE_EVEN -> Keeps even values
+//  - PIPELINE_ODD -> Keeps odd values
+//  - PIPELINE_POSITIVE -> Keeps values above 0
+typedef enum
+{
+    PIPELINE_EVEN,
+    PIPELINE_ODD,
+    PIPELINE_POSITIVE,
+    PIPELINE_N_FILTERS,
+} pipeline_filter;
+
+// pipeline_stage -> One map or filter step. The fused runs use op and filter to pick kernels
+//  specialized for them, the staged run calls map and predicate on every element
+//
+// FIELDS
+//  - int (*map)(int x) -> The function to apply to every element, or NULL for a filter stage
+//  - bool (*predicate)(int x) -> The elements to keep, or NULL for a map stage
+//  - map_op op -> The operator map computes
+//  - pipeline_filter filter -> The predicate predicate computes
+typedef struct
+{
+    int (*map)(int x);
+    bool (*predicate)(int x);
+    map_op op;
+    pipeline_filter filter;
+} pipeline_stage;
+
+// pipeline -> Any number of map and filter stages, in order, followed by a reduction
+//
+// FIELDS
+//  - pipeline_stage stages[] -> The map and filter stages
+//  - int n_stages -> The number of stages in use
+//  - const reduce_operator* reduce -> The reduction the surviving values are combined with
+typedef struct
+{
+    pipeline_stage stages[PIPELINE_MAX_STAGES];
+    int n_stages;
+    const reduce_operator *reduce;
+} pipeline;
+
+// bool (*pipeline_predicate())(int) -> The predicate called name ("even", "odd" or "positive"), or NULL
+bool (*pipeline_predicate(const char *name))(int x);
+
+// bool pipeline_parse() -> Builds a pipeline from a comma separated list of stages, e.g.
+//  "map:affine,filter:even,reduce:add". Map names come from simd_map.h, filter names from
+//  pipeline_predicate() and reduce names from reduction.h. The reduction is optional, but if
+//  there is one it must be the last stage. Without one p->reduce is NULL
+//
+// INPUTS
+//  - const char* spec -> The list of stages
+//  - pipeline* p -> The pipeline to fill in
+//
+// Returns false if a stage is unknown, there are too many stages or a stage follows the reduction
+bool pipeline_parse(const char *spec, pipeline *p);
+
+// int pipeline_run() -> Runs every stage of a pipeline that has a reduction fused in a single parallel pass. Each thread takes a
+//  contiguous range of PIPELINE_BLOCK sized blocks, and carries each block through the maps and
+//  filters in a buffer on its stack before folding the survivors into its partial. No intermediate
+//  array is ever allocated. Every stage runs over the whole block with a kernel specialized for it:
+//  simd_map_block() for maps, a compaction loop with the predicate inlined for filters and the
+//  operator's block kernel for the reduction. Partials are combined in thread order, so the
+//  reduction only has to be associative
+//
+// INPUTS
+//  - const pipeline* p -> The pipeline to run
+//  - const int vals[] -> The input values, which are not modified
+//  - long len -> The length of the value array
+//  - int n_threads -> The number of threads to use
+int pipeline_run(const pipeline *p, const int vals[], long len, int n_threads);
+
+// long pipeline_apply() -> Runs the map and filter stages fused in place, ignoring the reduction,
+//  and leaves the survivors at the front of vals in their original order. Every thread compacts its
+//  own range of blocks toward the start of that range, then the ranges are moved together in parallel
+//  through a scratch array, since one range's destination can overlap another's survivors
+//
+// INPUTS
+//  - const pipeline* p -> The pipeline to run
+//  - int vals[] -> The values to map and filter in place
+//  - long len -> The length of the value array
+//  - int n_threads -> The number of threads to use
+//
+// Returns the number of survivors
+long pipeline_apply(const pipeline *p, int vals[], long len, int n_threads);
+
+// int pipeline_run_staged() -> Runs the same pipeline one stage at a time the way the map, filter
+//  and reduce drivers do: every map rewrites a whole array, every filter counts, scans and copies the
+//  survivors into a newly allocated one, and reduce_run() reads the last array back
+//
+// Takes the same inputs as pipeline_run() and returns the same result
+int pipeline_run_staged(const pipeline *p, const int vals[], long len, int n_threads);
+
+#endif
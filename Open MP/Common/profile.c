@@ -0,0 +1,468 @@
+#include "profile.h"
+#include "padded.h"
+
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
+
+// thread_slot -> What one thread records during the current region, one cache line each
+typedef struct
+{
+    _Alignas(CACHE_LINE_SIZE) double begin;
+    double end;
+    double busy;
+    long long counters[PROFILE_N_COUNTERS];
+} thread_slot;
+
+// region_record -> One finished call of a region
+typedef struct
+{
+    const char *name;
+    int n_threads;
+    double begin;
+    double wall;
+    thread_slot *threads;
+} region_record;
+
+// trace_event -> One timeline event
+typedef struct
+{
+    const char *name;
+    double begin;
+    double end;
+    long first;
+    long last;
+} trace_event;
+
+// trace_row -> One thread's timeline events. Only thread tid appends to row tid, so no locking
+typedef struct
+{
+    _Alignas(CACHE_LINE_SIZE) trace_event *events;
+    int n_events;
+    int cap;
+} trace_row;
+
+static bool enabled = false;
+static bool use_counters = false;
+static bool tracing = false;
+static trace_row rows[PROFILE_MAX_THREADS];
+static double epoch;
+
+static thread_slot slots[PROFILE_MAX_THREADS];
+static const char *current_name = NULL;
+static double current_begin;
+static int current_threads;
+
+static region_record *records = NULL;
+static int n_records = 0;
+static int records_cap = 0;
+
+// Every thread opens its own counters the first time it is profiled. They count that thread only
+static _Thread_local int counter_fds[PROFILE_N_COUNTERS];
+static _Thread_local bool counters_opened = false;
+
+static void open_counters(void)
+{
+    counters_opened = true;
+    for (int c = 0; c < PROFILE_N_COUNTERS; c++)
+    {
+        counter_fds[c] = -1;
+    }
+#ifdef __linux__
+    static const struct
+    {
+        unsigned type;
+        unsigned long long config;
+    } events[PROFILE_N_COUNTERS] = {
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+        {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                 (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+    };
+
+    for (int c = 0; c < PROFILE_N_COUNTERS; c++)
+    {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = events[c].type;
+        attr.config = events[c].config;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        counter_fds[c] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+#endif
+}
+
+static void read_counters(long long values[PROFILE_N_COUNTERS])
+{
+    if (!counters_opened)
+    {
+        open_counters();
+    }
+    for (int c = 0; c < PROFILE_N_COUNTERS; c++)
+    {
+        values[c] = -1;
+        if (counter_fds[c] >= 0 && read(counter_fds[c], &values[c], sizeof(long long)) != sizeof(long long))
+        {
+            values[c] = -1;
+        }
+    }
+}
+
+void profile_enable(bool counters, bool trace)
+{
+    enabled = true;
+    use_counters = counters;
+    tracing = trace;
+    epoch = omp_get_wtime();
+}
+
+bool profile_enabled(void)
+{
+    return enabled;
+}
+
+bool profile_tracing(void)
+{
+    return tracing;
+}
+
+// Appends an event to row tid
+static void trace_add(int tid, const char *name, double begin, double end, long first, long last)
+{
+    if (tid >= PROFILE_MAX_THREADS)
+    {
+        return;
+    }
+    trace_row *row = &rows[tid];
+    if (row->n_events == row->cap)
+    {
+        row->cap = row->cap > 0 ? 2 * row->cap : 256;
+        row->events = realloc(row->events, row->cap * sizeof(trace_event));
+    }
+    trace_event event = {name, begin, end, first, last};
+    row->events[row->n_events] = event;
+    row->n_events++;
+}
+
+void profile_span(const char *name, double begin, double end, long first, long last)
+{
+    if (tracing)
+    {
+        trace_add(omp_get_thread_num(), name, begin, end, first, last);
+    }
+}
+
+void profile_region_begin(const char *name)
+{
+    if (!enabled)
+    {
+        return;
+    }
+    current_name = name;
+    current_threads = 0;
+    memset(slots, 0, sizeof(slots));
+    current_begin = omp_get_wtime();
+}
+
+void profile_thread_begin(void)
+{
+    if (current_name == NULL)
+    {
+        return;
+    }
+    int tid = omp_get_thread_num();
+    if (tid >= PROFILE_MAX_THREADS)
+    {
+        return;
+    }
+    thread_slot *slot = &slots[tid];
+    // The counters are read first and subtracted at the end, so reading them is not timed as work
+    if (use_counters)
+    {
+        read_counters(slot->counters);
+    }
+    slot->busy = -1;
+    slot->begin = omp_get_wtime();
+}
+
+void profile_thread_busy(double seconds)
+{
+    int tid = omp_get_thread_num();
+    if (current_name == NULL || tid >= PROFILE_MAX_THREADS)
+    {
+        return;
+    }
+    thread_slot *slot = &slots[tid];
+    slot->busy = (slot->busy < 0 ? 0 : slot->busy) + seconds;
+}
+
+void profile_thread_end(void)
+{
+    if (current_name == NULL)
+    {
+        return;
+    }
+    double now = omp_get_wtime();
+    int tid = omp_get_thread_num();
+    if (tid >= PROFILE_MAX_THREADS)
+    {
+        return;
+    }
+    thread_slot *slot = &slots[tid];
+    slot->end = now;
+    if (slot->busy < 0)
+    {
+        slot->busy = now - slot->begin;
+    }
+    if (use_counters)
+    {
+        long long after[PROFILE_N_COUNTERS];
+        read_counters(after);
+        for (int c = 0; c < PROFILE_N_COUNTERS; c++)
+        {
+            slot->counters[c] = after[c] >= 0 && slot->counters[c] >= 0 ? after[c] - slot->counters[c] : -1;
+        }
+    }
+    else
+    {
+        for (int c = 0; c < PROFILE_N_COUNTERS; c++)
+        {
+            slot->counters[c] = -1;
+        }
+    }
+
+    // Only the primary thread records the team size. It is also the thread that calls
+    // profile_region_end() after the closing barrier, so nothing else touches it concurrently
+    if (tid == 0)
+    {
+        int n = omp_get_num_threads();
+        current_threads = n < PROFILE_MAX_THREADS ? n : PROFILE_MAX_THREADS;
+    }
+}
+
+void profile_region_end(void)
+{
+    if (current_name == NULL)
+    {
+        return;
+    }
+    double wall = omp_get_wtime() - current_begin;
+
+    if (n_records == records_cap)
+    {
+        records_cap = records_cap > 0 ? 2 * records_cap : 64;
+        records = realloc(records, records_cap * sizeof(region_record));
+    }
+    region_record *record = &records[n_records];
+    n_records++;
+
+    record->name = current_name;
+    record->n_threads = current_threads;
+    record->begin = current_begin - epoch;
+    record->wall = wall;
+    record->threads = malloc((current_threads > 0 ? current_threads : 1) * sizeof(thread_slot));
+    memcpy(record->threads, slots, current_threads * sizeof(thread_slot));
+    current_name = NULL;
+
+    // The workers are done, so their rows can be written from here. Every thread's busy span is
+    // followed by its wait at the closing barrier, and the region itself goes on thread 0's row
+    if (tracing)
+    {
+        double end = current_begin + wall;
+        trace_add(0, record->name, current_begin, end, -1, -1);
+        for (int t = 0; t < current_threads; t++)
+        {
+            trace_add(t, "busy", slots[t].begin, slots[t].end, -1, -1);
+            trace_add(t, "barrier", slots[t].end, end, -1, -1);
+        }
+    }
+}
+
+// region_summary -> The per call means of one region at one thread count, for the CSV
+typedef struct
+{
+    const char *name;
+    int n_threads;
+    int calls;
+    double wall;
+    double busy_mean;
+    double busy_max;
+    double idle_mean;
+    double overhead;
+    long long counters[PROFILE_N_COUNTERS];
+} region_summary;
+
+static void summarize(const region_record *record, region_summary *summary)
+{
+    double busy_sum = 0;
+    double busy_max = 0;
+    for (int t = 0; t < record->n_threads; t++)
+    {
+        busy_sum += record->threads[t].busy;
+        busy_max = record->threads[t].busy > busy_max ? record->threads[t].busy : busy_max;
+        for (int c = 0; c < PROFILE_N_COUNTERS; c++)
+        {
+            long long value = record->threads[t].counters[c];
+            if (value < 0 || summary->counters[c] < 0)
+            {
+                summary->counters[c] = -1;
+            }
+            else
+            {
+                summary->counters[c] += value;
+            }
+        }
+    }
+    double busy_mean = record->n_threads > 0 ? busy_sum / record->n_threads : 0;
+
+    summary->calls++;
+    summary->wall += record->wall;
+    summary->busy_mean += busy_mean;
+    summary->busy_max += busy_max;
+    summary->idle_mean += record->wall - busy_mean;
+    summary->overhead += record->wall - busy_max;
+}
+
+static void write_csv(const char *path)
+{
+    FILE *fp = fopen(path, "w");
+    if (fp == NULL)
+    {
+        printf("Error opening file!\n");
+        exit(1);
+    }
+
+    // Group the calls by region name and thread count, in order of first appearance
+    region_summary *summaries = calloc(n_records > 0 ? n_records : 1, sizeof(region_summary));
+    int n_summaries = 0;
+    for (int r = 0; r < n_records; r++)
+    {
+        int s = 0;
+        while (s < n_summaries && !(strcmp(summaries[s].name, records[r].name) == 0 &&
+                                    summaries[s].n_threads == records[r].n_threads))
+        {
+            s++;
+        }
+        if (s == n_summaries)
+        {
+            summaries[s].name = records[r].name;
+            summaries[s].n_threads = records[r].n_threads;
+            n_summaries++;
+        }
+        summarize(&records[r], &summaries[s]);
+    }
+
+    fprintf(fp, "Region,Thread Count,Calls,Wall Time,Busy Mean,Busy Max,Idle Mean,Imbalance,Overhead,Cycles,Instructions,IPC,LLC Misses\n");
+    for (int s = 0; s < n_summaries; s++)
+    {
+        region_summary *summary = &summaries[s];
+        double calls = summary->calls;
+        long long cycles = summary->counters[PROFILE_CYCLES];
+        long long instructions = summary->counters[PROFILE_INSTRUCTIONS];
+        fprintf(fp, "%s,%d,%d,%lf,%lf,%lf,%lf,%lf,%lf,%lld,%lld,%lf,%lld\n", summary->name, summary->n_threads,
+                summary->calls, summary->wall / calls, summary->busy_mean / calls, summary->busy_max / calls,
+                summary->idle_mean / calls, summary->busy_mean > 0 ? summary->busy_max / summary->busy_mean : 1,
+                summary->overhead / calls, cycles, instructions,
+                cycles > 0 && instructions >= 0 ? (double)instructions / cycles : -1, summary->counters[PROFILE_LLC_MISSES]);
+    }
+
+    free(summaries);
+    fclose(fp);
+}
+
+static void write_json(const char *path)
+{
+    FILE *fp = fopen(path, "w");
+    if (fp == NULL)
+    {
+        printf("Error opening file!\n");
+        exit(1);
+    }
+
+    // Times are seconds since profile_enable()
+    fprintf(fp, "{\n  \"counters\": [\"cycles\", \"instructions\", \"llc_misses\"],\n  \"regions\": [");
+    for (int r = 0; r < n_records; r++)
+    {
+        region_record *record = &records[r];
+        fprintf(fp, "%s\n    {\"name\": \"%s\", \"threads\": %d, \"begin\": %.9f, \"wall\": %.9f, \"per_thread\": [",
+                r > 0 ? "," : "", record->name, record->n_threads, record->begin, record->wall);
+        for (int t = 0; t < record->n_threads; t++)
+        {
+            thread_slot *slot = &record->threads[t];
+            fprintf(fp, "%s\n      {\"begin\": %.9f, \"end\": %.9f, \"busy\": %.9f, \"counters\": [%lld, %lld, %lld]}",
+                    t > 0 ? "," : "", slot->begin - epoch, slot->end - epoch, slot->busy,
+                    slot->counters[PROFILE_CYCLES], slot->counters[PROFILE_INSTRUCTIONS], slot->counters[PROFILE_LLC_MISSES]);
+        }
+        fprintf(fp, "]}");
+    }
+    fprintf(fp, "\n  ]\n}\n");
+    fclose(fp);
+}
+
+static void write_trace(const char *path)
+{
+    FILE *fp = fopen(path, "w");
+    if (fp == NULL)
+    {
+        printf("Error opening file!\n");
+        exit(1);
+    }
+
+    // Complete ("X") events with microsecond timestamps since profile_enable(), plus a name per row
+    fprintf(fp, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [");
+    bool first = true;
+    for (int t = 0; t < PROFILE_MAX_THREADS; t++)
+    {
+        trace_row *row = &rows[t];
+        if (row->n_events == 0)
+        {
+            continue;
+        }
+        fprintf(fp, "%s\n  {\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": %d, \"args\": {\"name\": \"thread %d\"}}",
+                first ? "" : ",", t, t);
+        first = false;
+        for (int e = 0; e < row->n_events; e++)
+        {
+            trace_event *event = &row->events[e];
+            fprintf(fp, ",\n  {\"name\": \"%s\", \"ph\": \"X\", \"pid\": 0, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f",
+                    event->name, t, (event->begin - epoch) * 1e6, (event->end - event->begin) * 1e6);
+            if (event->first >= 0)
+            {
+                fprintf(fp, ", \"args\": {\"first\": %ld, \"last\": %ld}", event->first, event->last);
+            }
+            fprintf(fp, "}");
+        }
+    }
+    fprintf(fp, "\n]}\n");
+    fclose(fp);
+}
+
+void profile_write_report(const char *base)
+{
+    if (!enabled)
+    {
+        return;
+    }
+
+    char path[512];
+    snprintf(path, sizeof(path), "%s.csv", base);
+    write_csv(path);
+    snprintf(path, sizeof(path), "%s.json", base);
+    write_json(path);
+    printf("Profile written to %s.csv and %s.json successfully\n", base, base);
+    if (tracing)
+    {
+        snprintf(path, sizeof(path), "%s_trace.json", base);
+        write_trace(path);
+        printf("Trace written to %s successfully\n", path);
+    }
+}
@@ -0,0 +1,126 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <omp.h>
+#include <stdbool.h>
+
+// The most threads a profiled parallel region can have
+#define PROFILE_MAX_THREADS 256
+
+// profile_counter -> The hardware counters read around every thread's work when enabled
+typedef enum
+{
+    PROFILE_CYCLES,
+    PROFILE_INSTRUCTIONS,
+    PROFILE_LLC_MISSES,
+    PROFILE_N_COUNTERS,
+} profile_counter;
+
+// Instrumented parallel regions look like this. Every call does nothing until profile_enable()
+//
+//     profile_region_begin("map");
+//     #pragma omp parallel
+//     {
+//         profile_thread_begin();
+//         #pragma omp for nowait
+//         ...
+//         profile_thread_end();
+//     }
+//     profile_region_end();
+//
+// A thread is busy from profile_thread_begin() to profile_thread_end(), unless it reports its busy
+// time itself with profile_thread_busy(), and idle for the rest of the region's wall time. Regions
+// must not be nested
+//
+// With tracing on, every region, every thread's busy span and its wait at the closing barrier become
+// events on a Chrome trace timeline (chrome://tracing or ui.perfetto.dev), one row per thread. Kernels
+// add finer events with profile_span(): the chunks a thread ran, explicit barriers, serial steps
+
+// void profile_enable() -> Starts recording regions
+//
+// INPUTS
+//  - bool counters -> Whether to also read cycles, instructions and LLC misses with perf_event_open().
+//      Threads that cannot open the counters (no permission, not Linux) record -1 instead
+//  - bool trace -> Whether to also record timeline events
+void profile_enable(bool counters, bool trace);
+
+// bool profile_enabled() -> Whether regions are being recorded
+bool profile_enabled(void);
+
+// bool profile_tracing() -> Whether timeline events are being recorded
+bool profile_tracing(void);
+
+// void profile_span() -> Records a timeline event on the calling thread's row (serial code is
+//  thread 0). Does nothing unless tracing
+//
+// INPUTS
+//  - const char* name -> What happened, e.g. "chunk" or "barrier". Must stay valid until the report
+//  - double begin, end -> When, from omp_get_wtime()
+//  - long first, last -> The iterations [first, last) it covered, or -1 for both if that does not apply
+void profile_span(const char *name, double begin, double end, long first, long last);
+
+// void profile_region_begin() -> Starts a region. Call it from serial code right before the parallel
+//  region. name must stay valid until the report is written (a string literal, usually)
+void profile_region_begin(const char *name);
+
+// void profile_region_end() -> Ends the region, right after the parallel region
+void profile_region_end(void);
+
+// void profile_thread_begin() -> Marks the start of the calling thread's work in the current region
+void profile_thread_begin(void);
+
+// void profile_thread_busy() -> Adds seconds to the calling thread's busy time, for kernels where
+//  the thread is not busy for its whole span (a work stealing thread looking for work, say)
+void profile_thread_busy(double seconds);
+
+// void profile_thread_end() -> Marks the end of the calling thread's work in the current region
+void profile_thread_end(void);
+
+// profile_chunks -> Recovers the chunks a loop with a runtime schedule handed the calling thread.
+//  Call profile_chunk_next() at the top of every iteration and profile_chunk_done() after the loop:
+//  whenever the iteration number jumps, the previous run of consecutive iterations becomes a "chunk"
+//  event. Back to back chunks that go to the same thread show up as one. Without tracing both only
+//  test a flag
+typedef struct
+{
+    long first;
+    long next;
+    double begin;
+} profile_chunks;
+
+#define PROFILE_CHUNKS_INIT {-1, -1, 0}
+
+static inline void profile_chunk_next(profile_chunks *chunks, long i)
+{
+    if (i != chunks->next && profile_tracing())
+    {
+        double now = omp_get_wtime();
+        if (chunks->first >= 0)
+        {
+            profile_span("chunk", chunks->begin, now, chunks->first, chunks->next);
+        }
+        chunks->first = i;
+        chunks->begin = now;
+    }
+    chunks->next = i + 1;
+}
+
+static inline void profile_chunk_done(profile_chunks *chunks)
+{
+    if (chunks->first >= 0)
+    {
+        profile_span("chunk", chunks->begin, omp_get_wtime(), chunks->first, chunks->next);
+    }
+}
+
+// void profile_write_report() -> Writes <base>.csv, one row per region name and thread count with the
+//  mean wall, busy and idle times per call, the imbalance (largest busy time over the mean busy time),
+//  the fork/join overhead (wall time minus the largest busy time) and the counter totals, and
+//  <base>.json, every region call with every thread's span, busy time and counters, and when tracing
+//  <base>_trace.json, the Chrome trace event timeline. Does nothing if profiling was never enabled
+//
+// INPUTS
+//  - const char* base -> The path of the report without an extension, e.g. "Data/profile_data"
+void profile_write_report(const char *base);
+
+#endif
@@ -0,0 +1,262 @@
+#include "reduction.h"
+#include "padded.h"
+#include "profile.h"
+
+#include <limits.h>
+#include <omp.h>
+#include <stdlib.h>
+#include <string.h>
+
+int iadd(int x, int y) { return x + y; }
+// Multiply as unsigned so overflow wraps the same way in every evaluation order
+int imult(int x, int y) { return (int)((unsigned)x * (unsigned)y); }
+int imax(int x, int y) { return x > y ? x : y; }
+int imin(int x, int y) { return x < y ? x : y; }
+
+// Kernels using the reductions OpenMP has built in. The loops use the schedule
+// set with schedule_apply()
+static int add_kernel(const int vals[], int len, int n_threads)
+{
+    int result = 0;
+    profile_region_begin("reduce:add");
+#pragma omp parallel reduction(+ : result) num_threads(n_threads)
+    {
+        profile_thread_begin();
+#pragma omp for schedule(runtime) nowait
+        for (int i = 0; i < len; i++)
+        {
+            result += vals[i];
+        }
+        profile_thread_end();
+    }
+    profile_region_end();
+    return result;
+}
+
+static int mult_kernel(const int vals[], int len, int n_threads)
+{
+    unsigned result = 1;
+    profile_region_begin("reduce:mult");
+#pragma omp parallel reduction(* : result) num_threads(n_threads)
+    {
+        profile_thread_begin();
+#pragma omp for schedule(runtime) nowait
+        for (int i = 0; i < len; i++)
+        {
+            result *= (unsigned)vals[i];
+        }
+        profile_thread_end();
+    }
+    profile_region_end();
+    return (int)result;
+}
+
+static int max_kernel(const int vals[], int len, int n_threads)
+{
+    int result = INT_MIN;
+    profile_region_begin("reduce:max");
+#pragma omp parallel reduction(max : result) num_threads(n_threads)
+    {
+        profile_thread_begin();
+#pragma omp for schedule(runtime) nowait
+        for (int i = 0; i < len; i++)
+        {
+            result = vals[i] > result ? vals[i] : result;
+        }
+        profile_thread_end();
+    }
+    profile_region_end();
+    return result;
+}
+
+// Kernels using user defined reductions
+#pragma omp declare reduction(gcd : int : omp_out = gcd(omp_out, omp_in)) \
+    initializer(omp_priv = 0)
+
+#pragma omp declare reduction(imin : int : omp_out = imin(omp_out, omp_in)) \
+    initializer(omp_priv = INT_MAX)
+
+// Every thread reduces its block with the batched gcd, a chunk at a time, and
+// everyone stops once any thread has seen the running gcd reach 1
+#define GCD_CHUNK 65536
+
+static int gcd_kernel(const int vals[], int len, int n_threads)
+{
+    int result = 0;
+    int found_one = 0;
+
+    profile_region_begin("reduce:gcd");
+#pragma omp parallel reduction(gcd : result) num_threads(n_threads)
+    {
+        profile_thread_begin();
+        int tid = omp_get_thread_num();
+        int n = omp_get_num_threads();
+        long begin = (long)len * tid / n;
+        long end = (long)len * (tid + 1) / n;
+
+        for (long i = begin; i < end; i += GCD_CHUNK)
+        {
+            int stop;
+#pragma omp atomic read
+            stop = found_one;
+            if (stop)
+            {
+                result = 1;
+                break;
+            }
+
+            long chunk = end - i < GCD_CHUNK ? end - i : GCD_CHUNK;
+            double chunk_start = omp_get_wtime();
+            result = gcd_reduce_batch(vals + i, chunk, result);
+            profile_span("chunk", chunk_start, omp_get_wtime(), i, i + chunk);
+            if (result == 1)
+            {
+#pragma omp atomic write
+                found_one = 1;
+                break;
+            }
+        }
+        profile_thread_end();
+    }
+    profile_region_end();
+    return result;
+}
+
+static int min_kernel(const int vals[], int len, int n_threads)
+{
+    int result = INT_MAX;
+    profile_region_begin("reduce:min");
+#pragma omp parallel reduction(imin : result) num_threads(n_threads)
+    {
+        profile_thread_begin();
+#pragma omp for schedule(runtime) nowait
+        for (int i = 0; i < len; i++)
+        {
+            result = imin(result, vals[i]);
+        }
+        profile_thread_end();
+    }
+    profile_region_end();
+    return result;
+}
+
+// Block kernels: one thread, no parallel region, and a simd loop with the operator inlined.
+// The gcd one is gcd_reduce_batch()
+static int add_block(const int vals[], long len, int start)
+{
+    unsigned result = (unsigned)start;
+#pragma omp simd reduction(+ : result)
+    for (long i = 0; i < len; i++)
+    {
+        result += (unsigned)vals[i];
+    }
+    return (int)result;
+}
+
+static int mult_block(const int vals[], long len, int start)
+{
+    unsigned result = (unsigned)start;
+#pragma omp simd reduction(* : result)
+    for (long i = 0; i < len; i++)
+    {
+        result *= (unsigned)vals[i];
+    }
+    return (int)result;
+}
+
+static int max_block(const int vals[], long len, int start)
+{
+    int result = start;
+#pragma omp simd reduction(max : result)
+    for (long i = 0; i < len; i++)
+    {
+        result = vals[i] > result ? vals[i] : result;
+    }
+    return result;
+}
+
+static int min_block(const int vals[], long len, int start)
+{
+    int result = start;
+#pragma omp simd reduction(min : result)
+    for (long i = 0; i < len; i++)
+    {
+        result = vals[i] < result ? vals[i] : result;
+    }
+    return result;
+}
+
+static const reduce_operator operators[] = {
+    {"add", iadd, 0, add_kernel, add_block},
+    {"mult", imult, 1, mult_kernel, mult_block},
+    {"max", imax, INT_MIN, max_kernel, max_block},
+    {"min", imin, INT_MAX, min_kernel, min_block},
+    {"gcd", gcd, 0, gcd_kernel, gcd_reduce_batch},
+};
+
+const reduce_operator *reduce_find(const char *name)
+{
+    for (size_t i = 0; i < sizeof(operators) / sizeof(operators[0]); i++)
+    {
+        if (strcmp(operators[i].name, name) == 0)
+        {
+            return &operators[i];
+        }
+    }
+    return NULL;
+}
+
+int reduce_run(const reduce_operator *op, const int vals[], int len, int n_threads)
+{
+    if (op->kernel != NULL)
+    {
+        return op->kernel(vals, len, n_threads);
+    }
+    return reduce_tree(op, vals, len, n_threads);
+}
+
+int reduce_tree(const reduce_operator *op, const int vals[], int len, int n_threads)
+{
+    // The partials are combined repeatedly, so each one gets its own cache line
+    padded_int *partials = padded_calloc(n_threads, sizeof(padded_int));
+
+    profile_region_begin("reduce:tree");
+#pragma omp parallel num_threads(n_threads)
+    {
+        profile_thread_begin();
+        int tid = omp_get_thread_num();
+        int n = omp_get_num_threads();
+
+        // Reduce this thread's contiguous block
+        long begin = (long)len * tid / n;
+        long end = (long)len * (tid + 1) / n;
+        int local = op->identity;
+        for (long i = begin; i < end; i++)
+        {
+            local = op->func(local, vals[i]);
+        }
+        partials[tid].value = local;
+        profile_thread_end();
+
+        double wait = omp_get_wtime();
+#pragma omp barrier
+        profile_span("barrier", wait, omp_get_wtime(), -1, -1);
+
+        // Combine neighbouring partials, doubling the distance every step
+        for (int stride = 1; stride < n; stride *= 2)
+        {
+            if (tid % (2 * stride) == 0 && tid + stride < n)
+            {
+                partials[tid].value = op->func(partials[tid].value, partials[tid + stride].value);
+            }
+            wait = omp_get_wtime();
+#pragma omp barrier
+            profile_span("barrier", wait, omp_get_wtime(), -1, -1);
+        }
+    }
+    profile_region_end();
+
+    int result = partials[0].value;
+    free(partials);
+    return result;
+}
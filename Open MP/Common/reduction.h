@@ -0,0 +1,61 @@
+#ifndef REDUCTION_H
+#define REDUCTION_H
+
+#include "gcd.h"
+
+// Basic operator functions
+int iadd(int x, int y);
+int imult(int x, int y);
+int imax(int x, int y);
+int imin(int x, int y);
+
+// reduce_operator -> Describes one associative operator that the reduction engine can run
+//
+// FIELDS
+//  - const char* name -> The name used to pick the operator on the command line
+//  - int (*func)(int x, int y) -> The operator itself, used by the serial and tree paths
+//  - int identity -> The value v such that func(v, x) == x for every x
+//  - int (*kernel)(...) -> A parallel kernel compiled specifically for this operator,
+//      or NULL if the operator should always go through the tree combine fallback
+//  - int (*block)(...) -> Folds vals[0, len) into start on the calling thread with a loop compiled
+//      for this operator, for callers that reduce one block at a time inside their own parallel region
+typedef struct
+{
+    const char *name;
+    int (*func)(int x, int y);
+    int identity;
+    int (*kernel)(const int vals[], int len, int n_threads);
+    int (*block)(const int vals[], long len, int start);
+} reduce_operator;
+
+// const reduce_operator* reduce_find() -> Looks up an operator by name ("add", "mult", "max", "min", "gcd")
+//
+// INPUTS
+//  - const char* name -> The name of the operator
+//
+// Returns NULL if no operator has that name
+const reduce_operator *reduce_find(const char *name);
+
+// int reduce_run() -> Reduces vals in parallel with the operator's own kernel if it has one,
+//  and with the tree combine fallback otherwise. The add, mult, max and min kernels follow the
+//  schedule set with schedule_apply(), the gcd and tree kernels split the input into one block per thread
+//
+// INPUTS
+//  - const reduce_operator* op -> The operator to reduce with
+//  - const int vals[] -> The values to reduce
+//  - int len -> The length of the value array
+//  - int n_threads -> The number of threads to use
+int reduce_run(const reduce_operator *op, const int vals[], int len, int n_threads);
+
+// int reduce_tree() -> Reduces vals in parallel by having every thread reduce one contiguous
+//  block and then combining the per thread partials pairwise in log2(n_threads) steps.
+//  Blocks are combined left to right so the operator only has to be associative
+//
+// INPUTS
+//  - const reduce_operator* op -> The operator to reduce with
+//  - const int vals[] -> The values to reduce
+//  - int len -> The length of the value array
+//  - int n_threads -> The number of threads to use
+int reduce_tree(const reduce_operator *op, const int vals[], int len, int n_threads);
+
+#endif
@@ -0,0 +1,199 @@
+#include "rng.h"
+
+#include <math.h>
+#include <omp.h>
+#include <stdlib.h>
+#include <string.h>
+
+// The Philox4x32 round multipliers and key increments
+#define PHILOX_M0 0xD2511F53u
+#define PHILOX_M1 0xCD9E8D57u
+#define PHILOX_W0 0x9E3779B9u
+#define PHILOX_W1 0xBB67AE85u
+#define PHILOX_ROUNDS 10
+
+void rng_philox(uint64_t seed, uint64_t counter, uint32_t out[4])
+{
+    uint32_t c0 = (uint32_t)counter;
+    uint32_t c1 = (uint32_t)(counter >> 32);
+    uint32_t c2 = 0;
+    uint32_t c3 = 0;
+    uint32_t k0 = (uint32_t)seed;
+    uint32_t k1 = (uint32_t)(seed >> 32);
+
+    for (int r = 0; r < PHILOX_ROUNDS; r++)
+    {
+        uint64_t p0 = (uint64_t)PHILOX_M0 * c0;
+        uint64_t p1 = (uint64_t)PHILOX_M1 * c2;
+        uint32_t n0 = (uint32_t)(p1 >> 32) ^ c1 ^ k0;
+        uint32_t n2 = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+        c1 = (uint32_t)p1;
+        c3 = (uint32_t)p0;
+        c0 = n0;
+        c2 = n2;
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+
+    out[0] = c0;
+    out[1] = c1;
+    out[2] = c2;
+    out[3] = c3;
+}
+
+bool rng_self_test(void)
+{
+    uint32_t out[4];
+    rng_philox(0, 0, out);
+    return out[0] == 0x6627e8d5u && out[1] == 0xe169c58du && out[2] == 0xbc57ac4cu && out[3] == 0x9b00dbd8u;
+}
+
+bool rng_parse(const char *arg, rng_distribution *dist)
+{
+    dist->skew = 1.0;
+    if (strcmp(arg, "uniform") == 0)
+    {
+        dist->kind = RNG_UNIFORM;
+        return true;
+    }
+    if (strcmp(arg, "sorted") == 0)
+    {
+        dist->kind = RNG_SORTED;
+        return true;
+    }
+    if (strncmp(arg, "zipf", 4) == 0)
+    {
+        dist->kind = RNG_ZIPF;
+        if (arg[4] == ':')
+        {
+            dist->skew = atof(arg + 5);
+        }
+        return (arg[4] == '\0' || arg[4] == ':') && dist->skew > 0;
+    }
+    return false;
+}
+
+const char *rng_name(const rng_distribution *dist)
+{
+    static const char *names[] = {"uniform", "zipf", "sorted"};
+    return names[dist->kind];
+}
+
+// uint32_t word() -> The 32 bit random word for element i, one Philox call per four elements.
+//  Callers walk i in order from a multiple of 4 (every block starts on one), so out always
+//  holds the words of the current group of four
+static inline uint32_t word(uint64_t seed, long i, uint32_t out[4])
+{
+    if (i % 4 == 0)
+    {
+        rng_philox(seed, (uint64_t)i / 4, out);
+    }
+    return out[i % 4];
+}
+
+// double unit() -> Maps a word to (0, 1], never 0 so it can go through log() and pow()
+static inline double unit(uint32_t w)
+{
+    return ((double)w + 1.0) / 4294967296.0;
+}
+
+// Lemire's multiply and shift maps a word to [1, max_val] without a division
+static void fill_uniform(uint64_t seed, int vals[], long begin, long end, int max_val)
+{
+    uint32_t out[4];
+    for (long i = begin; i < end; i++)
+    {
+        vals[i] = 1 + (int)(((uint64_t)word(seed, i, out) * (uint64_t)max_val) >> 32);
+    }
+}
+
+// Inverts the CDF of the continuous density proportional to x^-skew on [1, max_val + 1) and rounds
+// down, which is close to a Zipf distribution and needs no table of max_val probabilities
+static void fill_zipf(uint64_t seed, double skew, int vals[], long begin, long end, int max_val)
+{
+    double top = (double)max_val + 1.0;
+    double scale = skew == 1.0 ? 0 : pow(top, 1.0 - skew) - 1.0;
+    uint32_t out[4];
+    for (long i = begin; i < end; i++)
+    {
+        double u = unit(word(seed, i, out));
+        double x = skew == 1.0 ? pow(top, u) : pow(1.0 + u * scale, 1.0 / (1.0 - skew));
+        int v = (int)x;
+        vals[i] = v < 1 ? 1 : v > max_val ? max_val : v;
+    }
+}
+
+// The running sums of n + 1 exponential gaps, divided by the last one, are distributed like
+// n sorted uniform values. Every block's sum of gaps is found first, then every block generates
+// its gaps again starting from the sum of the blocks before it
+static void fill_sorted(uint64_t seed, int vals[], long len, int max_val, int n_threads)
+{
+    long n_blocks = (len + RNG_BLOCK - 1) / RNG_BLOCK;
+    double *offsets = malloc((n_blocks + 1) * sizeof(double));
+
+#pragma omp parallel for schedule(static) num_threads(n_threads)
+    for (long b = 0; b < n_blocks; b++)
+    {
+        long begin = b * RNG_BLOCK;
+        long end = begin + RNG_BLOCK < len ? begin + RNG_BLOCK : len;
+        uint32_t out[4];
+        double sum = 0;
+        for (long i = begin; i < end; i++)
+        {
+            sum += -log(unit(word(seed, i, out)));
+        }
+        offsets[b + 1] = sum;
+    }
+
+    // Scanning the block sums in order keeps the rounding independent of the thread count
+    offsets[0] = 0;
+    for (long b = 0; b < n_blocks; b++)
+    {
+        offsets[b + 1] += offsets[b];
+    }
+    uint32_t last[4];
+    rng_philox(seed, (uint64_t)len / 4, last);
+    double total = offsets[n_blocks] + -log(unit(last[len % 4]));
+
+#pragma omp parallel for schedule(static) num_threads(n_threads)
+    for (long b = 0; b < n_blocks; b++)
+    {
+        long begin = b * RNG_BLOCK;
+        long end = begin + RNG_BLOCK < len ? begin + RNG_BLOCK : len;
+        uint32_t out[4];
+        double sum = offsets[b];
+        for (long i = begin; i < end; i++)
+        {
+            sum += -log(unit(word(seed, i, out)));
+            int v = 1 + (int)(sum / total * max_val);
+            vals[i] = v > max_val ? max_val : v;
+        }
+    }
+
+    free(offsets);
+}
+
+void rng_fill(const rng_distribution *dist, uint64_t seed, int vals[], long len, int max_val, int n_threads)
+{
+    if (dist->kind == RNG_SORTED)
+    {
+        fill_sorted(seed, vals, len, max_val, n_threads);
+        return;
+    }
+
+    long n_blocks = (len + RNG_BLOCK - 1) / RNG_BLOCK;
+#pragma omp parallel for schedule(static) num_threads(n_threads)
+    for (long b = 0; b < n_blocks; b++)
+    {
+        long begin = b * RNG_BLOCK;
+        long end = begin + RNG_BLOCK < len ? begin + RNG_BLOCK : len;
+        if (dist->kind == RNG_ZIPF)
+        {
+            fill_zipf(seed, dist->skew, vals, begin, end, max_val);
+        }
+        else
+        {
+            fill_uniform(seed, vals, begin, end, max_val);
+        }
+    }
+}
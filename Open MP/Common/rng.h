@@ -0,0 +1,70 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// The seed drivers use unless they are given one
+#define RNG_DEFAULT_SEED 297
+
+// Elements are generated in blocks of this many. The blocks, not the threads, decide how the
+// work is split, so the output does not depend on the number of threads
+#define RNG_BLOCK 65536
+
+// rng_kind -> The shape of the generated values, all in [1, max_val]
+//  - RNG_UNIFORM -> Every value equally likely
+//  - RNG_ZIPF -> Value k has probability roughly proportional to 1 / k^skew, so most values are
+//      small and a few are large. With the O(x) kernels that makes a few elements very expensive
+//  - RNG_SORTED -> Uniform values in increasing order, so the expensive elements are all at the end
+typedef enum
+{
+    RNG_UNIFORM,
+    RNG_ZIPF,
+    RNG_SORTED,
+} rng_kind;
+
+// rng_distribution -> A distribution to fill inputs with
+//
+// FIELDS
+//  - rng_kind kind -> The shape of the values
+//  - double skew -> The Zipf exponent, ignored by the other kinds
+typedef struct
+{
+    rng_kind kind;
+    double skew;
+} rng_distribution;
+
+// void rng_philox() -> The Philox4x32-10 counter based generator: four random 32 bit words that
+//  depend only on the seed and the counter, so any element can be generated on any thread in any order
+//
+// INPUTS
+//  - uint64_t seed -> The key
+//  - uint64_t counter -> Which block of four words to generate
+//  - uint32_t out[4] -> The four words
+void rng_philox(uint64_t seed, uint64_t counter, uint32_t out[4]);
+
+// bool rng_self_test() -> Checks rng_philox() against the published Philox4x32-10 known answer
+//  (key 0, counter 0), so a miscompiled generator is caught before it fills any input
+bool rng_self_test(void);
+
+// bool rng_parse() -> Parses "uniform", "sorted", "zipf" (skew 1) or "zipf:skew"
+//
+// Returns false if arg is none of those or the skew is not positive
+bool rng_parse(const char *arg, rng_distribution *dist);
+
+// const char* rng_name() -> The name of a distribution's kind
+const char *rng_name(const rng_distribution *dist);
+
+// void rng_fill() -> Fills vals in parallel. The same seed always gives the same values,
+//  whatever the number of threads
+//
+// INPUTS
+//  - const rng_distribution* dist -> The distribution to draw from
+//  - uint64_t seed -> The seed
+//  - int vals[] -> The array to fill
+//  - long len -> The length of the array
+//  - int max_val -> The largest value
+//  - int n_threads -> The number of threads to use
+void rng_fill(const rng_distribution *dist, uint64_t seed, int vals[], long len, int max_val, int n_threads);
+
+#endif
@@ -0,0 +1,181 @@
+#include "scan.h"
+
+#include <omp.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+// Number of elements in one lookback chunk, small enough that the output of a
+// chunk is still in L2 when the prefix is added to it
+#define SCAN_CHUNK 16384
+
+// long scan_block() -> Scans in[begin, end) serially into out starting from offset
+//  and returns the running total at the end of the block
+static long scan_block(const int in[], long out[], long begin, long end, long offset, bool inclusive)
+{
+    long sum = offset;
+    for (long i = begin; i < end; i++)
+    {
+        if (inclusive)
+        {
+            sum += in[i];
+            out[i] = sum;
+        }
+        else
+        {
+            out[i] = sum;
+            sum += in[i];
+        }
+    }
+    return sum;
+}
+
+static long scan_blocked(const int in[], long out[], long len, int n_threads, bool inclusive)
+{
+    long *block_offsets = malloc((n_threads + 1) * sizeof(long));
+    long total = 0;
+
+#pragma omp parallel num_threads(n_threads)
+    {
+        int tid = omp_get_thread_num();
+        int n = omp_get_num_threads();
+        long begin = len * tid / n;
+        long end = len * (tid + 1) / n;
+
+        // Pass 1: the sum of every block
+        long sum = 0;
+        for (long i = begin; i < end; i++)
+        {
+            sum += in[i];
+        }
+        block_offsets[tid + 1] = sum;
+
+#pragma omp barrier
+#pragma omp single
+        {
+            block_offsets[0] = 0;
+            for (int t = 0; t < n; t++)
+            {
+                block_offsets[t + 1] += block_offsets[t];
+            }
+            total = block_offsets[n];
+        }
+
+        // Pass 2: scan every block starting from the sum of the blocks before it
+        scan_block(in, out, begin, end, block_offsets[tid], inclusive);
+    }
+
+    free(block_offsets);
+    return total;
+}
+
+// Lookback status of a chunk
+#define STATUS_EMPTY 0
+#define STATUS_AGGREGATE 1
+#define STATUS_INCLUSIVE 2
+
+typedef struct
+{
+    atomic_int status;
+    long aggregate;
+    long inclusive;
+} chunk_status;
+
+static long scan_lookback(const int in[], long out[], long len, int n_threads, bool inclusive)
+{
+    long n_chunks = (len + SCAN_CHUNK - 1) / SCAN_CHUNK;
+    chunk_status *chunks = malloc((n_chunks > 0 ? n_chunks : 1) * sizeof(chunk_status));
+    for (long c = 0; c < n_chunks; c++)
+    {
+        atomic_init(&chunks[c].status, STATUS_EMPTY);
+    }
+    // Chunks are claimed in increasing order, so every chunk we wait on is already
+    // owned by a running thread and the lookback always makes progress
+    atomic_long next_chunk;
+    atomic_init(&next_chunk, 0);
+
+#pragma omp parallel num_threads(n_threads)
+    {
+        while (1)
+        {
+            long c = atomic_fetch_add(&next_chunk, 1);
+            if (c >= n_chunks)
+            {
+                break;
+            }
+            long begin = c * SCAN_CHUNK;
+            long end = begin + SCAN_CHUNK < len ? begin + SCAN_CHUNK : len;
+
+            // Scan the chunk locally, then let later chunks know its sum
+            long aggregate = scan_block(in, out, begin, end, 0, inclusive);
+            long prefix = 0;
+            if (c == 0)
+            {
+                chunks[c].inclusive = aggregate;
+                atomic_store_explicit(&chunks[c].status, STATUS_INCLUSIVE, memory_order_release);
+            }
+            else
+            {
+                chunks[c].aggregate = aggregate;
+                atomic_store_explicit(&chunks[c].status, STATUS_AGGREGATE, memory_order_release);
+
+                // Walk back, adding aggregates, until a chunk with a known inclusive prefix
+                long j = c - 1;
+                while (1)
+                {
+                    int status = atomic_load_explicit(&chunks[j].status, memory_order_acquire);
+                    if (status == STATUS_INCLUSIVE)
+                    {
+                        prefix += chunks[j].inclusive;
+                        break;
+                    }
+                    else if (status == STATUS_AGGREGATE)
+                    {
+                        prefix += chunks[j].aggregate;
+                        j--;
+                    }
+                }
+
+                chunks[c].inclusive = prefix + aggregate;
+                atomic_store_explicit(&chunks[c].status, STATUS_INCLUSIVE, memory_order_release);
+            }
+
+            // Add the prefix while the chunk is still in cache
+            if (prefix != 0)
+            {
+                for (long i = begin; i < end; i++)
+                {
+                    out[i] += prefix;
+                }
+            }
+        }
+    }
+
+    long total = n_chunks > 0 ? chunks[n_chunks - 1].inclusive : 0;
+    free(chunks);
+    return total;
+}
+
+static long scan(const int in[], long out[], long len, scan_variant variant, int n_threads, bool inclusive)
+{
+    switch (variant)
+    {
+    case SCAN_BLOCKED:
+        return scan_blocked(in, out, len, n_threads, inclusive);
+    case SCAN_LOOKBACK:
+        return scan_lookback(in, out, len, n_threads, inclusive);
+    case SCAN_SERIAL:
+    default:
+        return scan_block(in, out, 0, len, 0, inclusive);
+    }
+}
+
+long inclusive_scan(const int in[], long out[], long len, scan_variant variant, int n_threads)
+{
+    return scan(in, out, len, variant, n_threads, true);
+}
+
+long exclusive_scan(const int in[], long out[], long len, scan_variant variant, int n_threads)
+{
+    return scan(in, out, len, variant, n_threads, false);
+}
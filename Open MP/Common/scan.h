@@ -0,0 +1,35 @@
+#ifndef SCAN_H
+#define SCAN_H
+
+// scan_variant -> How a prefix sum should be computed
+//  - SCAN_SERIAL -> One thread, one pass
+//  - SCAN_BLOCKED -> Two passes: every thread sums its block, the block sums are scanned,
+//      then every thread scans its block again starting from its block's offset
+//  - SCAN_LOOKBACK -> One pass over chunks handed out in order. Each chunk publishes its sum,
+//      then looks back at the chunks before it until it finds one whose inclusive prefix is known
+typedef enum
+{
+    SCAN_SERIAL,
+    SCAN_BLOCKED,
+    SCAN_LOOKBACK,
+} scan_variant;
+
+// long inclusive_scan() -> Sets out[i] = in[0] + ... + in[i]
+//
+// INPUTS
+//  - const int in[] -> The values to scan
+//  - long out[] -> The output array, at least len long. Sums are 64 bit so they do not overflow
+//  - long len -> The length of the input array
+//  - scan_variant variant -> Which algorithm to use
+//  - int n_threads -> The number of threads to use (ignored for SCAN_SERIAL)
+//
+// Returns the sum of every element
+long inclusive_scan(const int in[], long out[], long len, scan_variant variant, int n_threads);
+
+// long exclusive_scan() -> Sets out[i] = in[0] + ... + in[i - 1], so out[0] = 0
+//
+// Takes the same inputs as inclusive_scan() and returns the sum of every element, which is
+// the value out[len] would have
+long exclusive_scan(const int in[], long out[], long len, scan_variant variant, int n_threads);
+
+#endif
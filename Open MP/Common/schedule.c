@@ -0,0 +1,129 @@
+#include "schedule.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// The schedules the auto tuner tries. Small dynamic chunks balance skewed work best
+// but pay for it in scheduling overhead, so a few chunk sizes of each kind are tried
+static const schedule_policy candidates[] = {
+    {omp_sched_static, 0, false},
+    {omp_sched_static, 1, false},
+    {omp_sched_static, 64, false},
+    {omp_sched_dynamic, 1, false},
+    {omp_sched_dynamic, 16, false},
+    {omp_sched_dynamic, 256, false},
+    {omp_sched_guided, 0, false},
+    {omp_sched_guided, 16, false},
+};
+
+// The policy the kernels are currently using
+static schedule_policy current = {omp_sched_static, 0, false};
+
+bool schedule_parse(const char *text, schedule_policy *policy)
+{
+    char kind[16];
+    const char *comma = strchr(text, ',');
+    size_t kind_len = comma != NULL ? (size_t)(comma - text) : strlen(text);
+    if (kind_len == 0 || kind_len >= sizeof(kind))
+    {
+        return false;
+    }
+    memcpy(kind, text, kind_len);
+    kind[kind_len] = '\0';
+
+    policy->steal = false;
+    if (strcmp(kind, "static") == 0)
+    {
+        policy->kind = omp_sched_static;
+    }
+    else if (strcmp(kind, "steal") == 0)
+    {
+        policy->kind = omp_sched_static;
+        policy->steal = true;
+    }
+    else if (strcmp(kind, "dynamic") == 0)
+    {
+        policy->kind = omp_sched_dynamic;
+    }
+    else if (strcmp(kind, "guided") == 0)
+    {
+        policy->kind = omp_sched_guided;
+    }
+    else
+    {
+        return false;
+    }
+
+    policy->chunk = 0;
+    if (comma != NULL)
+    {
+        char *end;
+        long chunk = strtol(comma + 1, &end, 10);
+        if (*end != '\0' || chunk < 1 || chunk > 1 << 30)
+        {
+            return false;
+        }
+        policy->chunk = (int)chunk;
+    }
+    return true;
+}
+
+bool schedule_option(const char *text, schedule_policy *policy, bool *tune)
+{
+    *tune = strcmp(text, "auto") == 0;
+    return *tune || schedule_parse(text, policy);
+}
+
+const char *schedule_name(const schedule_policy *policy)
+{
+    if (policy->steal)
+    {
+        return "steal";
+    }
+
+    switch (policy->kind)
+    {
+    case omp_sched_dynamic:
+        return "dynamic";
+    case omp_sched_guided:
+        return "guided";
+    case omp_sched_static:
+    default:
+        return "static";
+    }
+}
+
+void schedule_apply(const schedule_policy *policy)
+{
+    current = *policy;
+    omp_set_schedule(policy->kind, policy->chunk);
+}
+
+const schedule_policy *schedule_current(void)
+{
+    return &current;
+}
+
+schedule_policy schedule_autotune(double (*trial)(void *ctx), void *ctx)
+{
+    int n_candidates = sizeof(candidates) / sizeof(candidates[0]);
+    schedule_policy best = candidates[0];
+    double best_time = -1;
+
+    for (int c = 0; c < n_candidates; c++)
+    {
+        schedule_apply(&candidates[c]);
+        double time = trial(ctx);
+        printf("Autotune: %s,%d took %lf\n", schedule_name(&candidates[c]), candidates[c].chunk, time);
+
+        if (best_time < 0 || time < best_time)
+        {
+            best = candidates[c];
+            best_time = time;
+        }
+    }
+
+    schedule_apply(&best);
+    return best;
+}
@@ -0,0 +1,63 @@
+#ifndef SCHEDULE_H
+#define SCHEDULE_H
+
+#include <omp.h>
+#include <stdbool.h>
+
+// schedule_policy -> A loop schedule for the kernels that use schedule(runtime)
+//
+// FIELDS
+//  - omp_sched_t kind -> omp_sched_static, omp_sched_dynamic or omp_sched_guided
+//  - int chunk -> The chunk size in loop iterations, 0 for the OpenMP default
+//  - bool steal -> Whether the kernels that support it should use the work stealing runtime
+//      in steal.h instead of an OpenMP loop. chunk is then the grain size
+typedef struct
+{
+    omp_sched_t kind;
+    int chunk;
+    bool steal;
+} schedule_policy;
+
+// bool schedule_parse() -> Parses "static", "dynamic", "guided" or "steal", optionally followed by
+//  ",chunk" (the OMP_SCHEDULE format), into a policy
+//
+// INPUTS
+//  - const char* text -> The text to parse, e.g. "dynamic,64"
+//  - schedule_policy* policy -> Set to the parsed policy
+//
+// Returns false if the text is not a valid schedule
+bool schedule_parse(const char *text, schedule_policy *policy);
+
+// bool schedule_option() -> Parses the value of a driver's -s option, which is either a schedule
+//  accepted by schedule_parse() or "auto" to pick one with schedule_autotune()
+//
+// INPUTS
+//  - const char* text -> The option value
+//  - schedule_policy* policy -> Set to the parsed policy (left alone for "auto")
+//  - bool* tune -> Set to whether the driver should auto tune
+bool schedule_option(const char *text, schedule_policy *policy, bool *tune);
+
+// const char* schedule_name() -> The name of a policy's kind ("static", "dynamic", "guided" or "steal")
+const char *schedule_name(const schedule_policy *policy);
+
+// void schedule_apply() -> Makes the policy the one schedule(runtime) loops use from now on
+void schedule_apply(const schedule_policy *policy);
+
+// const schedule_policy* schedule_current() -> The policy last passed to schedule_apply(), which
+//  kernels check to decide whether to use the work stealing runtime
+const schedule_policy *schedule_current(void);
+
+// Number of input elements the drivers auto tune on
+#define SCHEDULE_SAMPLE_LEN 65536
+
+// schedule_policy schedule_autotune() -> Times every candidate OpenMP schedule on a sample of the
+//  work and applies and returns the fastest one. Work stealing is not a candidate since not every
+//  kernel supports it
+//
+// INPUTS
+//  - double (*trial)(void* ctx) -> Runs the kernel once on the sample, using whatever schedule
+//      is currently applied, and returns how long it took
+//  - void* ctx -> Passed through to trial
+schedule_policy schedule_autotune(double (*trial)(void *ctx), void *ctx);
+
+#endif
@@ -0,0 +1,85 @@
+#ifndef SERVICE_H
+#define SERVICE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// The wire protocol between the kernel service (Projects/service.c) and its clients. A client
+// connects to a Unix stream socket and sends any number of fixed size requests on the connection,
+// reading one reply after each. Both sides run on the same machine, so the structs go over the
+// socket as they are
+
+// The socket the service listens on unless told otherwise
+#define SERVICE_SOCKET "/tmp/omp_kernels.sock"
+
+// The longest pipeline and source name a request can carry, including the terminator
+#define SERVICE_MAX_PIPELINE 128
+#define SERVICE_MAX_SOURCE 256
+
+// Where the input of a job is
+//  - SERVICE_SHM -> A POSIX shared memory segment of native endian ints, named by source.
+//      Pipelines without a reduction leave their survivors at the front of the segment
+//  - SERVICE_FILE -> A binary or .csv file (see stream.h), which the service keeps loaded
+//      for the next job on the same file
+//  - SERVICE_SHUTDOWN -> Not a job: the service replies and exits
+typedef enum
+{
+    SERVICE_SHM,
+    SERVICE_FILE,
+    SERVICE_SHUTDOWN
+} service_source;
+
+// service_request -> One job
+//
+// FIELDS
+//  - int source -> A service_source
+//  - long len -> The number of ints to use from a shared memory segment, or 0 for all of it.
+//      Ignored for files
+//  - char pipeline[] -> The stages to run, in pipeline_parse() form, e.g. "filter:even,reduce:add"
+//      for a reduction or "map:square" to map in place
+//  - char source_name[] -> The shared memory segment name or file path
+typedef struct
+{
+    int source;
+    long len;
+    char pipeline[SERVICE_MAX_PIPELINE];
+    char source_name[SERVICE_MAX_SOURCE];
+} service_request;
+
+// service_reply -> The outcome of one job
+//
+// FIELDS
+//  - int status -> 0 on success, otherwise error holds why the job failed
+//  - int result -> The reduction, if the pipeline has one
+//  - long long elements -> The number of input values
+//  - long long survivors -> The number of values left after the filters, if there is no reduction
+//  - double compute_time -> The time spent in the kernels, without loading the input
+//  - char error[] -> What went wrong, when status is not 0
+typedef struct
+{
+    int status;
+    int result;
+    long long elements;
+    long long survivors;
+    double compute_time;
+    char error[2 * SERVICE_MAX_SOURCE];
+} service_reply;
+
+// int service_listen() -> Creates the listening socket at path, replacing any stale socket file
+//
+// Returns the socket, or -1 if it cannot be created
+int service_listen(const char *path);
+
+// int service_connect() -> Connects to the service listening at path
+//
+// Returns the connection, or -1 if nothing is listening there
+int service_connect(const char *path);
+
+// bool service_send() / service_recv() -> Write or read exactly size bytes, retrying partial
+//  transfers and interrupted calls. On a non blocking socket service_send() waits for room
+//
+// Return false if the connection is closed or fails first
+bool service_send(int fd, const void *msg, size_t size);
+bool service_recv(int fd, void *msg, size_t size);
+
+#endif
@@ -0,0 +1,280 @@
+#include "shard.h"
+
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "pipeline.h"
+
+// The kinds of job a worker runs on its shard
+//  - SHARD_REDUCE -> Reduce it into its slot's partial
+//  - SHARD_FILTER -> Filter it into scratch and set its slot's count
+//  - SHARD_MOVE -> Move its survivors from scratch to output at its slot's offset
+//  - SHARD_EXIT -> Exit
+typedef enum
+{
+    SHARD_REDUCE,
+    SHARD_FILTER,
+    SHARD_MOVE,
+    SHARD_EXIT
+} shard_task;
+
+// shard_job -> One job, sent to every worker taking part
+typedef struct
+{
+    int task;
+    int n_shards;
+    int n_threads;
+    long len;
+    char name[SHARD_MAX_NAME];
+} shard_job;
+
+// The values [begin, end) of shard w of n
+static long shard_begin(long len, int w, int n)
+{
+    return len * w / n;
+}
+
+// Runs one job on shard w. Returns false if the job cannot be run
+static bool run_job(shard_pool *pool, int w, const shard_job *job)
+{
+    long begin = shard_begin(job->len, w, job->n_shards);
+    long end = shard_begin(job->len, w + 1, job->n_shards);
+    shard_slot *slot = &pool->slots[w];
+
+    switch (job->task)
+    {
+    case SHARD_REDUCE:
+    {
+        const reduce_operator *op = reduce_find(job->name);
+        if (op == NULL)
+        {
+            return false;
+        }
+        slot->partial = reduce_run(op, pool->input + begin, (int)(end - begin), job->n_threads);
+        return true;
+    }
+    case SHARD_FILTER:
+    {
+        char spec[64];
+        snprintf(spec, sizeof(spec), "filter:%s", job->name);
+        pipeline p;
+        if (!pipeline_parse(spec, &p))
+        {
+            return false;
+        }
+#pragma omp parallel for schedule(static) num_threads(job->n_threads)
+        for (long i = begin; i < end; i++)
+        {
+            pool->scratch[i] = pool->input[i];
+        }
+        slot->count = pipeline_apply(&p, pool->scratch + begin, end - begin, job->n_threads);
+        return true;
+    }
+    case SHARD_MOVE:
+    {
+        int *from = pool->scratch + begin;
+        int *to = pool->output + slot->offset;
+#pragma omp parallel for schedule(static) num_threads(job->n_threads)
+        for (long i = 0; i < slot->count; i++)
+        {
+            to[i] = from[i];
+        }
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+// The loop of worker w: run jobs and acknowledge each with whether it succeeded
+static void worker_main(shard_pool *pool, int w, int jobs, int acks)
+{
+    shard_job job;
+    while (read(jobs, &job, sizeof(job)) == (ssize_t)sizeof(job) && job.task != SHARD_EXIT)
+    {
+        char ok = run_job(pool, w, &job);
+        if (write(acks, &ok, 1) != 1)
+        {
+            break;
+        }
+    }
+    _exit(0);
+}
+
+bool shard_pool_create(shard_pool *pool, int n_workers, long capacity)
+{
+    if (n_workers < 1 || n_workers > SHARD_MAX_WORKERS || capacity < 1)
+    {
+        return false;
+    }
+
+    pool->n_workers = 0;
+    pool->capacity = capacity;
+    size_t values = ((size_t)capacity * sizeof(int) + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+    pool->region_size = 3 * values + SHARD_MAX_WORKERS * sizeof(shard_slot);
+    pool->region = mmap(NULL, pool->region_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (pool->region == MAP_FAILED)
+    {
+        return false;
+    }
+    char *p = pool->region;
+    pool->input = (int *)p;
+    pool->scratch = (int *)(p + values);
+    pool->output = (int *)(p + 2 * values);
+    pool->slots = (shard_slot *)(p + 3 * values);
+
+    fflush(stdout);
+    for (int w = 0; w < n_workers; w++)
+    {
+        int jobs[2];
+        int acks[2];
+        if (pipe(jobs) != 0)
+        {
+            shard_pool_destroy(pool);
+            return false;
+        }
+        if (pipe(acks) != 0)
+        {
+            close(jobs[0]);
+            close(jobs[1]);
+            shard_pool_destroy(pool);
+            return false;
+        }
+
+        pid_t pid = fork();
+        if (pid == 0)
+        {
+            // The worker only keeps its own two ends
+            for (int i = 0; i < w; i++)
+            {
+                close(pool->to_worker[i]);
+                close(pool->from_worker[i]);
+            }
+            close(jobs[1]);
+            close(acks[0]);
+            worker_main(pool, w, jobs[0], acks[1]);
+        }
+
+        close(jobs[0]);
+        close(acks[1]);
+        if (pid < 0)
+        {
+            close(jobs[1]);
+            close(acks[0]);
+            shard_pool_destroy(pool);
+            return false;
+        }
+        pool->pids[w] = pid;
+        pool->to_worker[w] = jobs[1];
+        pool->from_worker[w] = acks[0];
+        pool->n_workers++;
+    }
+
+    return true;
+}
+
+// Sends job to the first n_shards workers and waits for all of them. Returns false if any failed
+static bool run_on_workers(shard_pool *pool, const shard_job *job)
+{
+    for (int w = 0; w < job->n_shards; w++)
+    {
+        if (write(pool->to_worker[w], job, sizeof(*job)) != (ssize_t)sizeof(*job))
+        {
+            printf("Error sending a job to worker %d!\n", w);
+            exit(1);
+        }
+    }
+
+    bool ok = true;
+    for (int w = 0; w < job->n_shards; w++)
+    {
+        char worker_ok;
+        if (read(pool->from_worker[w], &worker_ok, 1) != 1)
+        {
+            printf("Error: worker %d exited!\n", w);
+            exit(1);
+        }
+        ok = ok && worker_ok;
+    }
+    return ok;
+}
+
+// Fills in a job, clamping the number of shards to the workers there are
+static shard_job make_job(shard_pool *pool, int task, const char *name, long len, int n_shards, int n_threads)
+{
+    shard_job job;
+    memset(&job, 0, sizeof(job));
+    job.task = task;
+    job.n_shards = n_shards < 1 ? 1 : n_shards > pool->n_workers ? pool->n_workers : n_shards;
+    job.n_threads = n_threads < 1 ? 1 : n_threads;
+    job.len = len > pool->capacity ? pool->capacity : len;
+    snprintf(job.name, sizeof(job.name), "%s", name);
+    return job;
+}
+
+int shard_reduce(shard_pool *pool, const reduce_operator *op, long len, int n_shards, int n_threads)
+{
+    shard_job job = make_job(pool, SHARD_REDUCE, op->name, len, n_shards, n_threads);
+    if (!run_on_workers(pool, &job))
+    {
+        printf("Error: the workers do not know the operator %s!\n", op->name);
+        exit(1);
+    }
+
+    // Combine the partials pairwise, neighbours first, the same way reduce_tree() does
+    for (int step = 1; step < job.n_shards; step *= 2)
+    {
+        for (int w = 0; w + step < job.n_shards; w += 2 * step)
+        {
+            pool->slots[w].partial = op->func(pool->slots[w].partial, pool->slots[w + step].partial);
+        }
+    }
+    return pool->slots[0].partial;
+}
+
+long shard_filter(shard_pool *pool, const char *predicate, long len, int n_shards, int n_threads)
+{
+    shard_job job = make_job(pool, SHARD_FILTER, predicate, len, n_shards, n_threads);
+    if (!run_on_workers(pool, &job))
+    {
+        return -1;
+    }
+
+    long total = 0;
+    for (int w = 0; w < job.n_shards; w++)
+    {
+        pool->slots[w].offset = total;
+        total += pool->slots[w].count;
+    }
+
+    job.task = SHARD_MOVE;
+    run_on_workers(pool, &job);
+    return total;
+}
+
+void shard_pool_destroy(shard_pool *pool)
+{
+    shard_job job;
+    memset(&job, 0, sizeof(job));
+    job.task = SHARD_EXIT;
+    for (int w = 0; w < pool->n_workers; w++)
+    {
+        if (write(pool->to_worker[w], &job, sizeof(job)) != (ssize_t)sizeof(job))
+        {
+            printf("Error stopping worker %d!\n", w);
+        }
+        close(pool->to_worker[w]);
+        close(pool->from_worker[w]);
+    }
+    for (int w = 0; w < pool->n_workers; w++)
+    {
+        waitpid(pool->pids[w], NULL, 0);
+    }
+    pool->n_workers = 0;
+    munmap(pool->region, pool->region_size);
+}
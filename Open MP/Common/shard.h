@@ -0,0 +1,104 @@
+#ifndef SHARD_H
+#define SHARD_H
+
+#include <stdbool.h>
+#include <sys/types.h>
+
+#include "padded.h"
+#include "reduction.h"
+
+// The most worker processes one pool can have
+#define SHARD_MAX_WORKERS 64
+
+// The longest operator or predicate name a job can carry, including the terminator
+#define SHARD_MAX_NAME 16
+
+// shard_slot -> What one worker reports back for its shard, alone on its cache line
+//
+// FIELDS
+//  - int partial -> The reduction of the shard
+//  - long count -> The number of values of the shard that passed the filter
+//  - long offset -> Where the shard's survivors go in the output, set by the coordinator
+typedef struct
+{
+    _Alignas(CACHE_LINE_SIZE) int partial;
+    long count;
+    long offset;
+} shard_slot;
+
+// shard_pool -> Worker processes that run reductions and filters over shards of a shared input.
+//  The input, the workers' filter scratch, the output and the slots all live in one shared memory
+//  mapping made before the workers are forked, so nothing is copied between processes. Jobs and
+//  acknowledgements go over a pair of pipes per worker
+//
+// FIELDS
+//  - int n_workers -> The number of worker processes
+//  - pid_t pids[] -> The worker processes
+//  - int to_worker[], from_worker[] -> The write end of each worker's job pipe and the read end
+//      of its acknowledgement pipe
+//  - long capacity -> The most values a job can cover
+//  - int* input -> Where the caller puts the values, capacity long
+//  - int* scratch -> Where the workers filter their shards, capacity long
+//  - int* output -> Where shard_filter() leaves the survivors, capacity long
+//  - shard_slot* slots -> One per worker
+//  - void* region, size_t region_size -> The shared mapping holding all of the above
+typedef struct
+{
+    int n_workers;
+    pid_t pids[SHARD_MAX_WORKERS];
+    int to_worker[SHARD_MAX_WORKERS];
+    int from_worker[SHARD_MAX_WORKERS];
+    long capacity;
+    int *input;
+    int *scratch;
+    int *output;
+    shard_slot *slots;
+    void *region;
+    size_t region_size;
+} shard_pool;
+
+// bool shard_pool_create() -> Maps the shared region and forks the workers. The workers are
+//  copies of the caller, and an OpenMP runtime does not survive being forked with its thread pool
+//  running, so this has to be called before the caller's first OpenMP parallel region. The workers
+//  keep the schedule the caller set with schedule_apply() before the call
+//
+// INPUTS
+//  - shard_pool* pool -> The pool to set up
+//  - int n_workers -> The number of worker processes, at most SHARD_MAX_WORKERS
+//  - long capacity -> The most values a job can cover
+//
+// Returns false if the region cannot be mapped or a worker cannot be started
+bool shard_pool_create(shard_pool *pool, int n_workers, long capacity);
+
+// int shard_reduce() -> Reduces pool->input[0, len) with the first n_shards workers, each
+//  reducing one contiguous shard with reduce_run() on n_threads threads. The partials are then
+//  combined pairwise in shard order in log2(n_shards) steps, so the operator only has to be
+//  associative
+//
+// INPUTS
+//  - shard_pool* pool -> The pool, with the values in pool->input
+//  - const reduce_operator* op -> The operator to reduce with
+//  - long len -> The number of values
+//  - int n_shards -> The number of workers to split the values over
+//  - int n_threads -> The number of threads each worker uses
+int shard_reduce(shard_pool *pool, const reduce_operator *op, long len, int n_shards, int n_threads);
+
+// long shard_filter() -> Copies the values of pool->input[0, len) that pass the predicate to
+//  pool->output, in order. Every worker filters its shard into scratch, the coordinator places
+//  the shards with an exclusive scan of their counts, and every worker then moves its survivors
+//  into place
+//
+// INPUTS
+//  - shard_pool* pool -> The pool, with the values in pool->input
+//  - const char* predicate -> A pipeline_predicate() name
+//  - long len -> The number of values
+//  - int n_shards -> The number of workers to split the values over
+//  - int n_threads -> The number of threads each worker uses
+//
+// Returns the number of survivors, or -1 if there is no predicate with that name
+long shard_filter(shard_pool *pool, const char *predicate, long len, int n_shards, int n_threads);
+
+// void shard_pool_destroy() -> Stops and waits for the workers and unmaps the shared region
+void shard_pool_destroy(shard_pool *pool);
+
+#endif
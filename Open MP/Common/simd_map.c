@@ -0,0 +1,215 @@
+#include "simd_map.h"
+
+#include <omp.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86_KERNELS 1
+#endif
+
+// The operators. declare simd lets the compiler call vector versions of them from simd loops,
+// though in the kernels below they are simply inlined
+#pragma omp declare simd
+static inline int op_count(int x) { return x > 0 ? x : 0; }
+#pragma omp declare simd
+static inline int op_square(int x) { return (int)((unsigned)x * (unsigned)x); }
+#pragma omp declare simd
+static inline int op_affine(int x) { return (int)(3u * (unsigned)x + 1u); }
+#pragma omp declare simd
+static inline int op_abs(int x) { return x < 0 ? (int)(0u - (unsigned)x) : x; }
+
+// Out of line copies for callers that want a function pointer
+static int count_func(int x) { return op_count(x); }
+static int square_func(int x) { return op_square(x); }
+static int affine_func(int x) { return op_affine(x); }
+static int abs_func(int x) { return op_abs(x); }
+
+static const char *op_names[MAP_N_OPS] = {"count", "square", "affine", "abs"};
+static int (*op_funcs[MAP_N_OPS])(int x) = {count_func, square_func, affine_func, abs_func};
+
+// Every thread gets one contiguous block [begin, end) of the array
+#define THREAD_BLOCK(len, begin, end)                      \
+    int tid_ = omp_get_thread_num();                       \
+    int n_ = omp_get_num_threads();                        \
+    long begin = (long)((len) * tid_ / n_);                \
+    long end = (long)((len) * (tid_ + 1) / n_)
+
+// DEFINE_SIMD_KERNEL() -> Generates a portable block kernel with the operator inlined into a simd
+//  loop, and the parallel kernel that runs it on every thread's block
+#define DEFINE_SIMD_KERNEL(name)                                        \
+    static void simd_##name##_block(int vals[], long len)               \
+    {                                                                   \
+        _Pragma("omp simd")                                             \
+        for (long i = 0; i < len; i++)                                  \
+        {                                                               \
+            vals[i] = op_##name(vals[i]);                               \
+        }                                                               \
+    }                                                                   \
+    static void simd_##name(int vals[], long len, int n_threads)        \
+    {                                                                   \
+        _Pragma("omp parallel num_threads(n_threads)")                  \
+        {                                                               \
+            THREAD_BLOCK(len, begin, end);                              \
+            simd_##name##_block(vals + begin, end - begin);             \
+        }                                                               \
+    }
+
+DEFINE_SIMD_KERNEL(count)
+DEFINE_SIMD_KERNEL(square)
+DEFINE_SIMD_KERNEL(affine)
+DEFINE_SIMD_KERNEL(abs)
+
+static void (*simd_kernels[MAP_N_OPS])(int vals[], long len, int n_threads) = {
+    simd_count, simd_square, simd_affine, simd_abs};
+static void (*simd_blocks[MAP_N_OPS])(int vals[], long len) = {
+    simd_count_block, simd_square_block, simd_affine_block, simd_abs_block};
+
+#ifdef HAVE_X86_KERNELS
+
+// DEFINE_X86_KERNEL() -> Generates an intrinsics block kernel and its parallel kernel. vector_expr
+//  maps the register v, the scalar operator handles the tail. The target attribute lets the kernels
+//  use instructions the rest of the build was not compiled for, and map_isa_supported() makes sure
+//  they only run where they can
+#define DEFINE_X86_KERNEL(isa, target_isa, vec, width, load, store, name, vector_expr) \
+    __attribute__((target(target_isa))) static void isa##_##name##_block(int vals[], long len) \
+    {                                                                               \
+        long i = 0;                                                                 \
+        for (; i + (width) <= len; i += (width))                                    \
+        {                                                                           \
+            vec v = load((void *)(vals + i));                                       \
+            store((void *)(vals + i), (vector_expr));                               \
+        }                                                                           \
+        for (; i < len; i++)                                                        \
+        {                                                                           \
+            vals[i] = op_##name(vals[i]);                                           \
+        }                                                                           \
+    }                                                                               \
+    __attribute__((target(target_isa))) static void isa##_##name(int vals[], long len, int n_threads) \
+    {                                                                               \
+        _Pragma("omp parallel num_threads(n_threads)")                              \
+        {                                                                           \
+            THREAD_BLOCK(len, begin, end);                                          \
+            isa##_##name##_block(vals + begin, end - begin);                        \
+        }                                                                           \
+    }
+
+#define AVX2_KERNEL(name, vector_expr) \
+    DEFINE_X86_KERNEL(avx2, "avx2", __m256i, 8, _mm256_loadu_si256, _mm256_storeu_si256, name, vector_expr)
+#define AVX512_KERNEL(name, vector_expr) \
+    DEFINE_X86_KERNEL(avx512, "avx512f", __m512i, 16, _mm512_loadu_si512, _mm512_storeu_si512, name, vector_expr)
+
+AVX2_KERNEL(count, _mm256_max_epi32(v, _mm256_setzero_si256()))
+AVX2_KERNEL(square, _mm256_mullo_epi32(v, v))
+AVX2_KERNEL(affine, _mm256_add_epi32(_mm256_mullo_epi32(v, _mm256_set1_epi32(3)), _mm256_set1_epi32(1)))
+AVX2_KERNEL(abs, _mm256_abs_epi32(v))
+
+AVX512_KERNEL(count, _mm512_max_epi32(v, _mm512_setzero_si512()))
+AVX512_KERNEL(square, _mm512_mullo_epi32(v, v))
+AVX512_KERNEL(affine, _mm512_add_epi32(_mm512_mullo_epi32(v, _mm512_set1_epi32(3)), _mm512_set1_epi32(1)))
+AVX512_KERNEL(abs, _mm512_abs_epi32(v))
+
+static void (*avx2_kernels[MAP_N_OPS])(int vals[], long len, int n_threads) = {
+    avx2_count, avx2_square, avx2_affine, avx2_abs};
+static void (*avx512_kernels[MAP_N_OPS])(int vals[], long len, int n_threads) = {
+    avx512_count, avx512_square, avx512_affine, avx512_abs};
+static void (*avx2_blocks[MAP_N_OPS])(int vals[], long len) = {
+    avx2_count_block, avx2_square_block, avx2_affine_block, avx2_abs_block};
+static void (*avx512_blocks[MAP_N_OPS])(int vals[], long len) = {
+    avx512_count_block, avx512_square_block, avx512_affine_block, avx512_abs_block};
+
+#endif
+
+int map_op_find(const char *name)
+{
+    for (int op = 0; op < MAP_N_OPS; op++)
+    {
+        if (strcmp(op_names[op], name) == 0)
+        {
+            return op;
+        }
+    }
+    return -1;
+}
+
+const char *map_op_name(map_op op)
+{
+    return op_names[op];
+}
+
+int (*map_op_func(map_op op))(int x)
+{
+    return op_funcs[op];
+}
+
+bool map_isa_supported(map_isa isa)
+{
+    switch (isa)
+    {
+    case MAP_ISA_SIMD:
+        return true;
+#ifdef HAVE_X86_KERNELS
+    case MAP_ISA_AVX2:
+        return __builtin_cpu_supports("avx2");
+    case MAP_ISA_AVX512:
+        return __builtin_cpu_supports("avx512f");
+#endif
+    default:
+        return false;
+    }
+}
+
+map_isa map_isa_best(void)
+{
+    if (map_isa_supported(MAP_ISA_AVX512))
+    {
+        return MAP_ISA_AVX512;
+    }
+    if (map_isa_supported(MAP_ISA_AVX2))
+    {
+        return MAP_ISA_AVX2;
+    }
+    return MAP_ISA_SIMD;
+}
+
+const char *map_isa_name(map_isa isa)
+{
+    static const char *names[MAP_N_ISAS] = {"simd", "avx2", "avx512"};
+    return names[isa];
+}
+
+void simd_map(map_op op, map_isa isa, int vals[], long len, int n_threads)
+{
+    switch (isa)
+    {
+#ifdef HAVE_X86_KERNELS
+    case MAP_ISA_AVX2:
+        avx2_kernels[op](vals, len, n_threads);
+        break;
+    case MAP_ISA_AVX512:
+        avx512_kernels[op](vals, len, n_threads);
+        break;
+#endif
+    default:
+        simd_kernels[op](vals, len, n_threads);
+        break;
+    }
+}
+
+void simd_map_block(map_op op, map_isa isa, int vals[], long len)
+{
+    switch (isa)
+    {
+#ifdef HAVE_X86_KERNELS
+    case MAP_ISA_AVX2:
+        avx2_blocks[op](vals, len);
+        break;
+    case MAP_ISA_AVX512:
+        avx512_blocks[op](vals, len);
+        break;
+#endif
+    default:
+        simd_blocks[op](vals, len);
+        break;
+    }
+}
@@ -0,0 +1,72 @@
+#ifndef SIMD_MAP_H
+#define SIMD_MAP_H
+
+#include <stdbool.h>
+
+// map_op -> The element wise operators that have compile time specialized kernels
+//  - MAP_OP_COUNT -> max(x, 0), what map_function() in map.c computes by counting
+//  - MAP_OP_SQUARE -> x * x
+//  - MAP_OP_AFFINE -> 3 * x + 1
+//  - MAP_OP_ABS -> |x|
+// Products wrap around on overflow, the same way the vector multiply instructions do
+typedef enum
+{
+    MAP_OP_COUNT,
+    MAP_OP_SQUARE,
+    MAP_OP_AFFINE,
+    MAP_OP_ABS,
+    MAP_N_OPS,
+} map_op;
+
+// map_isa -> Which kernel implementation to run
+//  - MAP_ISA_SIMD -> Portable kernels vectorized by the compiler with #pragma omp simd
+//  - MAP_ISA_AVX2 -> Hand written AVX2 intrinsics, 8 ints per instruction
+//  - MAP_ISA_AVX512 -> Hand written AVX-512 intrinsics, 16 ints per instruction
+typedef enum
+{
+    MAP_ISA_SIMD,
+    MAP_ISA_AVX2,
+    MAP_ISA_AVX512,
+    MAP_N_ISAS,
+} map_isa;
+
+// int map_op_find() -> The operator called name ("count", "square", "affine" or "abs"), or -1
+int map_op_find(const char *name);
+
+// const char* map_op_name() -> The name of an operator
+const char *map_op_name(map_op op);
+
+// int (*map_op_func())(int) -> A plain function computing the operator, for function pointer kernels
+int (*map_op_func(map_op op))(int x);
+
+// bool map_isa_supported() -> Whether this build and the CPU it is running on can run isa
+bool map_isa_supported(map_isa isa);
+
+// map_isa map_isa_best() -> The widest implementation the CPU supports, checked at runtime
+map_isa map_isa_best(void);
+
+// const char* map_isa_name() -> The name of an implementation ("simd", "avx2" or "avx512")
+const char *map_isa_name(map_isa isa);
+
+// void simd_map() -> Applies op to every element of vals in place using the given implementation,
+//  with every thread working on one contiguous block. isa must be supported (see map_isa_supported())
+//
+// INPUTS
+//  - map_op op -> The operator to apply
+//  - map_isa isa -> The implementation to use
+//  - int vals[] -> The values to map
+//  - long len -> The length of the value array
+//  - int n_threads -> The number of threads to use
+void simd_map(map_op op, map_isa isa, int vals[], long len, int n_threads);
+
+// void simd_map_block() -> The same kernel as simd_map() run on the calling thread only, for
+//  callers that are already inside a parallel region and map one block at a time
+//
+// INPUTS
+//  - map_op op -> The operator to apply
+//  - map_isa isa -> The implementation to use
+//  - int vals[] -> The values to map
+//  - long len -> The length of the value array
+void simd_map_block(map_op op, map_isa isa, int vals[], long len);
+
+#endif
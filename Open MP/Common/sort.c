@@ -0,0 +1,207 @@
+#include "sort.h"
+
+#include <omp.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RADIX_BUCKETS (1 << SORT_RADIX_BITS)
+#define RADIX_MASK (RADIX_BUCKETS - 1)
+
+int sort_compare(const void *a, const void *b)
+{
+    int x = *(const int *)a;
+    int y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+// Flipping the sign bit makes unsigned digit order match signed value order
+static inline unsigned radix_key(int x)
+{
+    return (unsigned)x ^ 0x80000000u;
+}
+
+void radix_sort(int vals[], int tmp[], long len, int n_threads)
+{
+    // One row of bucket counts per thread, each row turned into that thread's write positions
+    long(*counts)[RADIX_BUCKETS] = malloc((size_t)n_threads * sizeof(*counts));
+    int *src = vals;
+    int *dst = tmp;
+
+#pragma omp parallel num_threads(n_threads)
+    {
+        int tid = omp_get_thread_num();
+        int n = omp_get_num_threads();
+        long begin = len * tid / n;
+        long end = len * (tid + 1) / n;
+
+        for (int shift = 0; shift < 32; shift += SORT_RADIX_BITS)
+        {
+            // Pass 1: count the digits of this thread's block
+            long *mine = counts[tid];
+            memset(mine, 0, sizeof(counts[0]));
+            for (long i = begin; i < end; i++)
+            {
+                mine[(radix_key(src[i]) >> shift) & RADIX_MASK]++;
+            }
+#pragma omp barrier
+
+            // Every thread can tell on its own whether one digit holds every value
+            bool skip = false;
+            for (int d = 0; d < RADIX_BUCKETS && !skip; d++)
+            {
+                long total = 0;
+                for (int t = 0; t < n; t++)
+                {
+                    total += counts[t][d];
+                }
+                skip = total == len;
+            }
+#pragma omp barrier
+            if (skip)
+            {
+                continue;
+            }
+
+            // Scan the counts digit by digit, thread by thread, into write positions
+#pragma omp single
+            {
+                long offset = 0;
+                for (int d = 0; d < RADIX_BUCKETS; d++)
+                {
+                    for (int t = 0; t < n; t++)
+                    {
+                        long count = counts[t][d];
+                        counts[t][d] = offset;
+                        offset += count;
+                    }
+                }
+            }
+
+            // Pass 2: scatter this thread's block to its write positions
+            for (long i = begin; i < end; i++)
+            {
+                int x = src[i];
+                dst[mine[(radix_key(x) >> shift) & RADIX_MASK]++] = x;
+            }
+#pragma omp barrier
+
+#pragma omp single
+            {
+                int *swap = src;
+                src = dst;
+                dst = swap;
+            }
+        }
+
+        // After an odd number of passes the sorted values are in tmp
+        if (src != vals)
+        {
+            memcpy(vals + begin, src + begin, (end - begin) * sizeof(int));
+        }
+    }
+
+    free(counts);
+}
+
+// The bucket of x: the number of splitters less than or equal to it
+static int sample_bucket(int x, const int splitters[], int n_splitters)
+{
+    int lo = 0;
+    int hi = n_splitters;
+    while (lo < hi)
+    {
+        int mid = (lo + hi) / 2;
+        if (splitters[mid] <= x)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+void sample_sort(int vals[], int tmp[], long len, int n_threads)
+{
+    if (n_threads < 2 || len < (long)n_threads * SORT_OVERSAMPLE)
+    {
+        qsort(vals, len, sizeof(int), sort_compare);
+        return;
+    }
+
+    // Pick the splitters from an evenly spaced sample
+    int n_samples = n_threads * SORT_OVERSAMPLE;
+    int *samples = malloc(n_samples * sizeof(int));
+    for (int s = 0; s < n_samples; s++)
+    {
+        samples[s] = vals[(long)((double)len * s / n_samples)];
+    }
+    qsort(samples, n_samples, sizeof(int), sort_compare);
+    int *splitters = malloc((n_threads - 1) * sizeof(int));
+    for (int b = 1; b < n_threads; b++)
+    {
+        splitters[b - 1] = samples[b * SORT_OVERSAMPLE];
+    }
+
+    // counts[t * n_threads + b] is how many values of thread t's block fall in bucket b,
+    // then where the next of them goes. starts[b] is where bucket b begins
+    long *counts = malloc((size_t)n_threads * n_threads * sizeof(long));
+    long *starts = malloc((n_threads + 1) * sizeof(long));
+
+#pragma omp parallel num_threads(n_threads)
+    {
+        int tid = omp_get_thread_num();
+        int n = omp_get_num_threads();
+        long begin = len * tid / n;
+        long end = len * (tid + 1) / n;
+        long *mine = counts + (size_t)tid * n_threads;
+
+        memset(mine, 0, n_threads * sizeof(long));
+        for (long i = begin; i < end; i++)
+        {
+            mine[sample_bucket(vals[i], splitters, n_threads - 1)]++;
+        }
+#pragma omp barrier
+
+#pragma omp single
+        {
+            long offset = 0;
+            for (int b = 0; b < n_threads; b++)
+            {
+                starts[b] = offset;
+                for (int t = 0; t < n; t++)
+                {
+                    long count = counts[(size_t)t * n_threads + b];
+                    counts[(size_t)t * n_threads + b] = offset;
+                    offset += count;
+                }
+            }
+            starts[n_threads] = offset;
+        }
+
+        for (long i = begin; i < end; i++)
+        {
+            int x = vals[i];
+            tmp[mine[sample_bucket(x, splitters, n_threads - 1)]++] = x;
+        }
+#pragma omp barrier
+
+        // Every bucket only holds values between its splitters, so sorting each one and copying
+        // them back sorts the whole array. Buckets differ in size (a value repeated many times all
+        // lands in one), so they are handed out dynamically
+#pragma omp for schedule(dynamic, 1)
+        for (int b = 0; b < n_threads; b++)
+        {
+            qsort(tmp + starts[b], starts[b + 1] - starts[b], sizeof(int), sort_compare);
+            memcpy(vals + starts[b], tmp + starts[b], (starts[b + 1] - starts[b]) * sizeof(int));
+        }
+    }
+
+    free(samples);
+    free(splitters);
+    free(counts);
+    free(starts);
+}
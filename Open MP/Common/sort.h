@@ -0,0 +1,37 @@
+#ifndef SORT_H
+#define SORT_H
+
+// The number of bits one radix sort pass sorts by. 8 bits is 256 buckets per thread, whose
+// counters and write positions fit in L1 alongside the data being scattered
+#define SORT_RADIX_BITS 8
+
+// The number of samples sample_sort() takes per bucket to pick its splitters. More samples make
+// the buckets more even at the cost of sorting a bigger sample
+#define SORT_OVERSAMPLE 64
+
+// void radix_sort() -> Sorts vals in ascending order with a parallel least significant digit
+//  radix sort: every pass, each thread counts the digits of its own contiguous block, the counts
+//  are scanned digit by digit and thread by thread into write positions, and each thread scatters
+//  its block to them. Blocks keep their order, so every pass is stable. A pass where every value
+//  has the same digit (such as the high digits when the values are small) is skipped
+//
+// INPUTS
+//  - int vals[] -> The values to sort, which end up sorted in place
+//  - int tmp[] -> Scratch space, at least len long
+//  - long len -> The length of the value array
+//  - int n_threads -> The number of threads to use
+void radix_sort(int vals[], int tmp[], long len, int n_threads);
+
+// void sample_sort() -> Sorts vals in ascending order with a parallel sample sort: n_threads - 1
+//  splitters are picked from an evenly spaced sample, every thread counts how many of its block's
+//  values fall into each bucket, the counts are scanned into write positions, the values are
+//  scattered to their buckets and each thread sorts one bucket. Only comparisons are used, so the
+//  cost does not grow with the width of the keys the way the radix sort's number of passes does
+//
+// Takes the same inputs as radix_sort()
+void sample_sort(int vals[], int tmp[], long len, int n_threads);
+
+// int sort_compare() -> Compares two ints for qsort(), in ascending order
+int sort_compare(const void *a, const void *b);
+
+#endif
@@ -0,0 +1,180 @@
+#include "steal.h"
+#include "padded.h"
+#include "profile.h"
+
+#include <omp.h>
+#include <assert.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+// Splitting halves a range each time, so a deque never holds more than a couple of
+// ranges per bit of len
+#define DEQUE_SIZE 256
+
+// A range is packed into one 64 bit word (begin in the high half, end in the low half)
+// so it can be read and written atomically
+#define RANGE_PACK(begin, end) (((uint64_t)(begin) << 32) | (uint64_t)(end))
+#define RANGE_BEGIN(range) ((long)((range) >> 32))
+#define RANGE_END(range) ((long)((range) & 0xffffffffu))
+
+// steal_deque -> A Chase-Lev deque. The owner pushes and takes at the bottom,
+//  thieves steal from the top. top and bottom get their own cache lines
+typedef struct
+{
+    _Alignas(CACHE_LINE_SIZE) atomic_long top;
+    _Alignas(CACHE_LINE_SIZE) atomic_long bottom;
+    _Atomic uint64_t items[DEQUE_SIZE];
+} steal_deque;
+
+// The memory orders follow Le et al., "Correct and Efficient Work-Stealing for Weak Memory Models"
+static void deque_push(steal_deque *d, uint64_t range)
+{
+    long b = atomic_load_explicit(&d->bottom, memory_order_relaxed);
+    long t = atomic_load_explicit(&d->top, memory_order_acquire);
+    assert(b - t < DEQUE_SIZE);
+    (void)t;
+
+    atomic_store_explicit(&d->items[b % DEQUE_SIZE], range, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+}
+
+static int deque_take(steal_deque *d, uint64_t *range)
+{
+    long b = atomic_load_explicit(&d->bottom, memory_order_relaxed) - 1;
+    atomic_store_explicit(&d->bottom, b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    long t = atomic_load_explicit(&d->top, memory_order_relaxed);
+
+    if (t > b)
+    {
+        // Empty
+        atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+        return 0;
+    }
+
+    *range = atomic_load_explicit(&d->items[b % DEQUE_SIZE], memory_order_relaxed);
+    if (t == b)
+    {
+        // Last item, race the thieves for it
+        int won = atomic_compare_exchange_strong_explicit(&d->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed);
+        atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+        return won;
+    }
+    return 1;
+}
+
+static int deque_steal(steal_deque *d, uint64_t *range)
+{
+    long t = atomic_load_explicit(&d->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    long b = atomic_load_explicit(&d->bottom, memory_order_acquire);
+
+    if (t >= b)
+    {
+        return 0;
+    }
+
+    *range = atomic_load_explicit(&d->items[t % DEQUE_SIZE], memory_order_relaxed);
+    return atomic_compare_exchange_strong_explicit(&d->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed);
+}
+
+long steal_for(long len, long grain, steal_body body, void *ctx, int n_threads)
+{
+    assert(len >= 0 && len <= 0xffffffffL);
+    if (grain <= 0)
+    {
+        grain = len / (64L * n_threads);
+        grain = grain > 0 ? grain : 1;
+    }
+
+    steal_deque *deques = aligned_alloc(CACHE_LINE_SIZE, n_threads * sizeof(steal_deque));
+    // Iterations that have not been run yet, every thread stops once this reaches 0
+    atomic_long remaining;
+    atomic_init(&remaining, len);
+    atomic_long steals;
+    atomic_init(&steals, 0);
+
+    profile_region_begin("steal");
+#pragma omp parallel num_threads(n_threads)
+    {
+        int tid = omp_get_thread_num();
+        int n = omp_get_num_threads();
+        steal_deque *own = &deques[tid];
+
+        // Seed every deque with an equal slice, then wait for everyone so no thief
+        // sees a deque that is not set up yet
+        atomic_init(&own->top, 0);
+        atomic_init(&own->bottom, 0);
+        long begin = len * tid / n;
+        long end = len * (tid + 1) / n;
+        if (begin < end)
+        {
+            deque_push(own, RANGE_PACK(begin, end));
+        }
+        double seeded = omp_get_wtime();
+#pragma omp barrier
+        profile_span("barrier", seeded, omp_get_wtime(), -1, -1);
+        profile_thread_begin();
+
+        unsigned seed = 2463534242u + tid;
+        long my_steals = 0;
+        while (atomic_load_explicit(&remaining, memory_order_relaxed) > 0)
+        {
+            uint64_t range;
+            int found = deque_take(own, &range);
+
+            // Out of local work, try a random victim
+            if (!found && n > 1)
+            {
+                seed ^= seed << 13;
+                seed ^= seed >> 17;
+                seed ^= seed << 5;
+                int victim = (int)(seed % (n - 1));
+                victim += victim >= tid;
+
+                found = deque_steal(&deques[victim], &range);
+                my_steals += found;
+                if (!found)
+                {
+                    // Give the CPU back in case there are more threads than cores
+                    sched_yield();
+                    continue;
+                }
+            }
+            if (!found)
+            {
+                continue;
+            }
+
+            // Keep the front half and leave the back half for us or a thief
+            long b = RANGE_BEGIN(range);
+            long e = RANGE_END(range);
+            while (e - b > grain)
+            {
+                long mid = b + (e - b) / 2;
+                deque_push(own, RANGE_PACK(mid, e));
+                e = mid;
+            }
+
+            // Only time spent in the body counts as busy, looking for work does not
+            double body_start = profile_enabled() ? omp_get_wtime() : 0;
+            body(b, e, ctx);
+            if (profile_enabled())
+            {
+                double body_end = omp_get_wtime();
+                profile_thread_busy(body_end - body_start);
+                profile_span("chunk", body_start, body_end, b, e);
+            }
+            atomic_fetch_sub_explicit(&remaining, e - b, memory_order_relaxed);
+        }
+        atomic_fetch_add(&steals, my_steals);
+        profile_thread_end();
+    }
+    profile_region_end();
+
+    free(deques);
+    return atomic_load(&steals);
+}
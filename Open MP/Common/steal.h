@@ -0,0 +1,23 @@
+#ifndef STEAL_H
+#define STEAL_H
+
+// steal_body -> The work for one range of loop iterations [begin, end)
+typedef void (*steal_body)(long begin, long end, void *ctx);
+
+// long steal_for() -> Runs body over [0, len) on a work stealing runtime instead of an OpenMP
+//  loop schedule. Every thread starts with an equal slice in its own Chase-Lev deque. A thread
+//  works on the front half of a range and pushes the back half onto its deque until the range is
+//  no bigger than grain. Threads that run out of work steal the oldest (largest) range from a
+//  random other thread, so expensive parts of the input get split up and spread around
+//
+// INPUTS
+//  - long len -> The number of loop iterations, at most 2^32 - 1
+//  - long grain -> The largest range that is run without splitting, 0 to pick one from len
+//  - steal_body body -> Called for every range
+//  - void* ctx -> Passed through to body
+//  - int n_threads -> The number of worker threads
+//
+// Returns the number of successful steals
+long steal_for(long len, long grain, steal_body body, void *ctx, int n_threads);
+
+#endif
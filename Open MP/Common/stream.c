@@ -0,0 +1,250 @@
+#include "stream.h"
+
+#include <limits.h>
+#include <omp.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+
+// size_t read_binary() -> Reads up to max whole ints. A partial int at the end of the file is dropped
+static size_t read_binary(stream *s, int *dst, size_t max)
+{
+    size_t n = fread(dst, sizeof(int), max, s->fp);
+    s->bytes_read += (long long)(n * sizeof(int));
+    return n;
+}
+
+// The fewest characters the window keeps ahead of a field, so a field is never split. Longer
+// fields cannot hold a number that fits in an int anyway
+#define TEXT_LOOKAHEAD 32
+
+// bool is_separator() -> Whether c ends a CSV field. Whitespace counts, so values may also be
+//  separated or padded by spaces
+static inline bool is_separator(char c)
+{
+    return c == ',' || c == '\n' || c == '\r' || c == ' ' || c == '\t';
+}
+
+// bool starts_number() -> Whether the field at text begins like a number, optionally in double
+//  quotes. Only a first field that does not is taken as a header, so 1.5 or 1e6 there is an error
+static inline bool starts_number(const char *text)
+{
+    char c = text[0] == '"' ? text[1] : text[0];
+    return c == '-' || (c >= '0' && c <= '9');
+}
+
+// bool parse_field() -> Parses the field text[0, len) as one int, optionally in double quotes
+static bool parse_field(const char *text, size_t len, int *value)
+{
+    if (len >= 2 && text[0] == '"' && text[len - 1] == '"')
+    {
+        text++;
+        len -= 2;
+    }
+    if (len == 0 || !starts_number(text))
+    {
+        return false;
+    }
+
+    char *end;
+    long parsed = strtol(text, &end, 10);
+    if (end != text + len || parsed < INT_MIN || parsed > INT_MAX)
+    {
+        return false;
+    }
+    *value = (int)parsed;
+    return true;
+}
+
+// size_t read_csv() -> Parses up to max integers out of the text window, one field at a time,
+//  refilling the window whenever fewer than TEXT_LOOKAHEAD characters are left. Empty fields are
+//  skipped. If the first field of the file does not start like a number the first line is skipped
+//  as a header, any other field that is not entirely an int sets bad_value and ends the stream
+static size_t read_csv(stream *s, int *dst, size_t max)
+{
+    size_t n = 0;
+    while (n < max)
+    {
+        if (s->text_len - s->text_pos < TEXT_LOOKAHEAD && !s->text_eof)
+        {
+            size_t left = s->text_len - s->text_pos;
+            memmove(s->text, s->text + s->text_pos, left);
+            size_t got = fread(s->text + left, 1, STREAM_TEXT_SIZE - left, s->fp);
+            s->bytes_read += (long long)got;
+            s->text_eof = got == 0;
+            s->text_len = left + got;
+            s->text_pos = 0;
+            s->text[s->text_len] = '\0';
+        }
+        if (s->text_pos == s->text_len)
+        {
+            if (s->text_eof)
+            {
+                break;
+            }
+            continue;
+        }
+
+        // Skipping the header line, which may be longer than the window
+        if (s->text_header)
+        {
+            char *newline = memchr(s->text + s->text_pos, '\n', s->text_len - s->text_pos);
+            s->text_pos = newline != NULL ? (size_t)(newline - s->text) + 1 : s->text_len;
+            s->text_header = newline == NULL;
+            continue;
+        }
+        if (is_separator(s->text[s->text_pos]))
+        {
+            s->text_pos++;
+            continue;
+        }
+
+        // The field runs to the next separator. One that does not end within the lookahead is
+        // too long to be an int
+        char *start = s->text + s->text_pos;
+        size_t visible = s->text_len - s->text_pos;
+        size_t field_len = 0;
+        while (field_len < visible && field_len < TEXT_LOOKAHEAD && !is_separator(start[field_len]))
+        {
+            field_len++;
+        }
+        bool whole = field_len < visible ? is_separator(start[field_len]) : s->text_eof;
+
+        int value;
+        if (whole && parse_field(start, field_len, &value))
+        {
+            dst[n] = value;
+            n++;
+            s->text_pos += field_len;
+        }
+        else if (!s->text_started && !starts_number(start))
+        {
+            s->text_header = true;
+        }
+        else
+        {
+            s->bad_value = true;
+            break;
+        }
+        s->text_started = true;
+    }
+    return n;
+}
+
+// The reader fills the slots in turn, waiting whenever the caller still has the one it wants.
+// A chunk of 0 integers tells the caller the file is done
+static void *reader_main(void *arg)
+{
+    stream *s = arg;
+    int slot = 0;
+    for (;;)
+    {
+        pthread_mutex_lock(&s->lock);
+        while (s->full[slot] && !s->stop)
+        {
+            pthread_cond_wait(&s->changed, &s->lock);
+        }
+        bool stop = s->stop;
+        pthread_mutex_unlock(&s->lock);
+        if (stop)
+        {
+            break;
+        }
+
+        double start = omp_get_wtime();
+        size_t n = s->csv ? read_csv(s, s->slots[slot].data, s->chunk_len)
+                          : read_binary(s, s->slots[slot].data, s->chunk_len);
+        double elapsed = omp_get_wtime() - start;
+
+        pthread_mutex_lock(&s->lock);
+        s->read_time += elapsed;
+        s->filled[slot] = n;
+        s->full[slot] = true;
+        pthread_cond_broadcast(&s->changed);
+        pthread_mutex_unlock(&s->lock);
+
+        if (n == 0)
+        {
+            break;
+        }
+        slot ^= 1;
+    }
+    return NULL;
+}
+
+bool stream_open(const char *path, size_t chunk_len, int n_threads, stream *s)
+{
+    memset(s, 0, sizeof(*s));
+    s->fp = fopen(path, "rb");
+    if (s->fp == NULL)
+    {
+        return false;
+    }
+#ifdef POSIX_FADV_SEQUENTIAL
+    posix_fadvise(fileno(s->fp), 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+    size_t path_len = strlen(path);
+    s->csv = path_len >= 4 && strcmp(path + path_len - 4, ".csv") == 0;
+    if (s->csv)
+    {
+        s->text = malloc(STREAM_TEXT_SIZE + 1);
+    }
+
+    s->chunk_len = chunk_len > 0 ? chunk_len : STREAM_CHUNK_LEN;
+    s->slots[0] = buffer_alloc(s->chunk_len, n_threads);
+    s->slots[1] = buffer_alloc(s->chunk_len, n_threads);
+    s->held = -1;
+
+    pthread_mutex_init(&s->lock, NULL);
+    pthread_cond_init(&s->changed, NULL);
+    pthread_create(&s->reader, NULL, reader_main, s);
+    return true;
+}
+
+bool stream_next(stream *s, int **data, size_t *len)
+{
+    double start = omp_get_wtime();
+    pthread_mutex_lock(&s->lock);
+
+    // The caller is done with its chunk, so the reader may refill it
+    if (s->held >= 0)
+    {
+        s->full[s->held] = false;
+        s->held = -1;
+        pthread_cond_broadcast(&s->changed);
+    }
+
+    while (!s->full[s->next])
+    {
+        pthread_cond_wait(&s->changed, &s->lock);
+    }
+    size_t n = s->filled[s->next];
+    if (n > 0)
+    {
+        *data = s->slots[s->next].data;
+        *len = n;
+        s->held = s->next;
+        s->next ^= 1;
+    }
+
+    pthread_mutex_unlock(&s->lock);
+    s->wait_time += omp_get_wtime() - start;
+    return n > 0;
+}
+
+void stream_close(stream *s)
+{
+    pthread_mutex_lock(&s->lock);
+    s->stop = true;
+    pthread_cond_broadcast(&s->changed);
+    pthread_mutex_unlock(&s->lock);
+    pthread_join(s->reader, NULL);
+
+    pthread_mutex_destroy(&s->lock);
+    pthread_cond_destroy(&s->changed);
+    buffer_free(&s->slots[0]);
+    buffer_free(&s->slots[1]);
+    free(s->text);
+    fclose(s->fp);
+}
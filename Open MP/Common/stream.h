@@ -0,0 +1,95 @@
+#ifndef STREAM_H
+#define STREAM_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include "buffer.h"
+
+// The default number of integers per chunk, 64MB of ints
+#define STREAM_CHUNK_LEN (16 * 1024 * 1024)
+
+// The size of the text window a CSV input is parsed through
+#define STREAM_TEXT_SIZE (1024 * 1024)
+
+// stream -> Reads a file of integers one fixed size chunk at a time, with a reader thread filling
+//  one of two chunk buffers while the caller works on the other. A file whose name ends in .csv is
+//  read as text (int fields separated by commas, whitespace or newlines, after an optional header
+//  line), anything else as native endian binary ints like buffer_map_file() expects
+//
+// FIELDS
+//  - FILE* fp -> The open input file
+//  - bool csv -> Whether the input is text
+//  - size_t chunk_len -> The most integers one chunk holds
+//  - int_buffer slots[2] -> The two chunk buffers
+//  - size_t filled[2] -> How many integers the reader put into each slot
+//  - bool full[2] -> Whether each slot holds a chunk the caller has not finished with
+//  - int next -> The slot the caller gets next
+//  - int held -> The slot the caller is working on, or -1
+//  - bool stop -> Tells the reader to give up early
+//  - char* text, size_t text_len, text_pos, bool text_eof -> The CSV parsing window
+//  - bool text_started -> Whether the first field has been read, i.e. the header decided on
+//  - bool text_header -> Whether the parser is skipping the header line
+//  - bool bad_value -> Whether the CSV held a field that is not an int, such as 1.5, 1e6 or a
+//      number out of range. Reading stops there, so callers should check it once stream_next()
+//      returns false
+//  - pthread_t reader, pthread_mutex_t lock, pthread_cond_t changed -> The reader thread and
+//      what it and the caller use to pass slots back and forth
+//  - long long bytes_read -> The bytes read from the file so far
+//  - double read_time -> The time the reader spent reading and parsing
+//  - double wait_time -> The time the caller spent waiting for a chunk, i.e. the reads that
+//      did not overlap with computation
+typedef struct
+{
+    FILE *fp;
+    bool csv;
+    size_t chunk_len;
+    int_buffer slots[2];
+    size_t filled[2];
+    bool full[2];
+    int next;
+    int held;
+    bool stop;
+    char *text;
+    size_t text_len;
+    size_t text_pos;
+    bool text_eof;
+    bool text_started;
+    bool text_header;
+    bool bad_value;
+    pthread_t reader;
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    long long bytes_read;
+    double read_time;
+    double wait_time;
+} stream;
+
+// bool stream_open() -> Opens path and starts reading its first chunk in the background
+//
+// INPUTS
+//  - const char* path -> The binary or .csv input file
+//  - size_t chunk_len -> The most integers per chunk
+//  - int n_threads -> The number of threads that first touch the chunk buffers
+//  - stream* s -> The stream to set up
+//
+// Returns false if the file cannot be opened
+bool stream_open(const char *path, size_t chunk_len, int n_threads, stream *s);
+
+// bool stream_next() -> Hands back the chunk the caller was working on and waits for the next one.
+//  The chunk may be modified in place, and stays valid until the next call
+//
+// INPUTS
+//  - stream* s -> The stream to read from
+//  - int** data -> Set to the first integer of the chunk
+//  - size_t* len -> Set to the number of integers in the chunk
+//
+// Returns false once the whole file has been read
+bool stream_next(stream *s, int **data, size_t *len);
+
+// void stream_close() -> Stops the reader, closes the file and frees the chunk buffers
+void stream_close(stream *s);
+
+#endif
@@ -0,0 +1,176 @@
+#include "wide_reduce.h"
+
+#include <limits.h>
+#include <math.h>
+#include <omp.h>
+#include <string.h>
+
+// The number of independent accumulators every thread keeps. 32 64-bit lanes fill four
+// AVX-512 registers (eight AVX2 ones), enough to hide the latency of the adds
+#define WIDE_STRIDE 32
+
+static const char *op_names[WIDE_N_OPS] = {"add", "mult", "max", "min"};
+
+int wide_op_find(const char *name)
+{
+    for (int op = 0; op < WIDE_N_OPS; op++)
+    {
+        if (strcmp(op_names[op], name) == 0)
+        {
+            return op;
+        }
+    }
+    return -1;
+}
+
+const char *wide_op_name(wide_op op)
+{
+    return op_names[op];
+}
+
+// Every thread gets one contiguous block [begin, end) of the array
+#define THREAD_BLOCK(len, begin, end)                      \
+    int tid_ = omp_get_thread_num();                       \
+    int n_ = omp_get_num_threads();                        \
+    long begin = (len) * tid_ / n_;                        \
+    long end = (len) * (tid_ + 1) / n_
+
+#define ADD(x, y) ((x) + (y))
+#define MAX(x, y) ((x) > (y) ? (x) : (y))
+#define MIN(x, y) ((x) < (y) ? (x) : (y))
+
+// DEFINE_BLOCK() -> Generates a function reducing vals[begin, end) with WIDE_STRIDE accumulators
+//  of the given type. The inner loop has no dependency between its iterations, so it turns into
+//  a few vector instructions working on independent registers
+#define DEFINE_BLOCK(name, type, identity, combine)                             \
+    static type name##_block(const int vals[], long begin, long end)            \
+    {                                                                           \
+        type acc[WIDE_STRIDE];                                                  \
+        for (int j = 0; j < WIDE_STRIDE; j++)                                   \
+        {                                                                       \
+            acc[j] = (identity);                                                \
+        }                                                                       \
+        long i = begin;                                                         \
+        for (; i + WIDE_STRIDE <= end; i += WIDE_STRIDE)                        \
+        {                                                                       \
+            _Pragma("omp simd")                                                 \
+            for (int j = 0; j < WIDE_STRIDE; j++)                               \
+            {                                                                   \
+                acc[j] = combine(acc[j], (type)vals[i + j]);                    \
+            }                                                                   \
+        }                                                                       \
+        type result = (identity);                                               \
+        for (; i < end; i++)                                                    \
+        {                                                                       \
+            result = combine(result, (type)vals[i]);                            \
+        }                                                                       \
+        for (int j = 0; j < WIDE_STRIDE; j++)                                   \
+        {                                                                       \
+            result = combine(result, acc[j]);                                   \
+        }                                                                       \
+        return result;                                                          \
+    }
+
+DEFINE_BLOCK(add, long long, 0, ADD)
+DEFINE_BLOCK(max, int, INT_MIN, MAX)
+DEFINE_BLOCK(min, int, INT_MAX, MIN)
+
+// The product is accumulated unsigned so it wraps instead of overflowing. Its magnitude is
+// tracked alongside in a double, which holds every product below 2^53 exactly and rounds
+// monotonically above that, so comparing it against INT_MAX is exact. Both are kept in the
+// same pass so the data is only read once
+static unsigned long long mult_block(const int vals[], long begin, long end, double *magnitude)
+{
+    unsigned long long acc[WIDE_STRIDE];
+    double mag[WIDE_STRIDE];
+    for (int j = 0; j < WIDE_STRIDE; j++)
+    {
+        acc[j] = 1;
+        mag[j] = 1.0;
+    }
+    long i = begin;
+    for (; i + WIDE_STRIDE <= end; i += WIDE_STRIDE)
+    {
+#pragma omp simd
+        for (int j = 0; j < WIDE_STRIDE; j++)
+        {
+            acc[j] *= (unsigned long long)vals[i + j];
+            mag[j] *= (double)vals[i + j];
+        }
+    }
+    unsigned long long result = 1;
+    double result_mag = 1.0;
+    for (; i < end; i++)
+    {
+        result *= (unsigned long long)vals[i];
+        result_mag *= (double)vals[i];
+    }
+    for (int j = 0; j < WIDE_STRIDE; j++)
+    {
+        result *= acc[j];
+        result_mag *= mag[j];
+    }
+    *magnitude = result_mag;
+    return result;
+}
+
+wide_result wide_reduce(wide_op op, const int vals[], long len, int n_threads)
+{
+    wide_result result = {0, false};
+
+    switch (op)
+    {
+    case WIDE_ADD:
+    {
+        // Sums of fewer than 2^32 ints cannot overflow 64 bits
+        long long sum = 0;
+#pragma omp parallel reduction(+ : sum) num_threads(n_threads)
+        {
+            THREAD_BLOCK(len, begin, end);
+            sum = add_block(vals, begin, end);
+        }
+        result.value = sum;
+        result.overflow = sum > INT_MAX || sum < INT_MIN;
+        break;
+    }
+    case WIDE_MULT:
+    {
+        unsigned long long product = 1;
+        double magnitude = 1.0;
+#pragma omp parallel reduction(* : product, magnitude) num_threads(n_threads)
+        {
+            THREAD_BLOCK(len, begin, end);
+            product = mult_block(vals, begin, end, &magnitude);
+        }
+        result.value = (long long)product;
+        // A zero times an infinity is NaN, which compares false and is right: the product is 0
+        result.overflow = fabs(magnitude) > INT_MAX;
+        break;
+    }
+    case WIDE_MAX:
+    {
+        int max = INT_MIN;
+#pragma omp parallel reduction(max : max) num_threads(n_threads)
+        {
+            THREAD_BLOCK(len, begin, end);
+            max = max_block(vals, begin, end);
+        }
+        result.value = max;
+        break;
+    }
+    case WIDE_MIN:
+    {
+        int min = INT_MAX;
+#pragma omp parallel reduction(min : min) num_threads(n_threads)
+        {
+            THREAD_BLOCK(len, begin, end);
+            min = min_block(vals, begin, end);
+        }
+        result.value = min;
+        break;
+    }
+    default:
+        break;
+    }
+    return result;
+}
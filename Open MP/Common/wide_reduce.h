@@ -0,0 +1,50 @@
+#ifndef WIDE_REDUCE_H
+#define WIDE_REDUCE_H
+
+#include <stdbool.h>
+
+// wide_op -> The operators with vectorized wide accumulator kernels. The names match the
+//  reduce_operator names in reduction.h
+//  - WIDE_ADD -> The sum, accumulated in 64 bits
+//  - WIDE_MULT -> The product, accumulated in 64 bits and wrapping past that
+//  - WIDE_MAX -> The largest value
+//  - WIDE_MIN -> The smallest value
+typedef enum
+{
+    WIDE_ADD,
+    WIDE_MULT,
+    WIDE_MAX,
+    WIDE_MIN,
+    WIDE_N_OPS,
+} wide_op;
+
+// wide_result -> The result of a wide reduction
+//
+// FIELDS
+//  - long long value -> The result. Its low 32 bits are what the int kernels in reduction.h return
+//  - bool overflow -> Whether the exact result does not fit in an int, i.e. whether the int
+//      kernels would have wrapped around
+typedef struct
+{
+    long long value;
+    bool overflow;
+} wide_result;
+
+// int wide_op_find() -> The operator called name ("add", "mult", "max" or "min"), or -1
+int wide_op_find(const char *name);
+
+// const char* wide_op_name() -> The name of an operator
+const char *wide_op_name(wide_op op);
+
+// wide_result wide_reduce() -> Reduces vals in parallel. Every thread reduces one contiguous block
+//  into WIDE_STRIDE independent accumulators that the compiler keeps in vector registers, so the
+//  loop is limited by how fast the data arrives rather than by the latency of one dependency chain
+//
+// INPUTS
+//  - wide_op op -> The operator to reduce with
+//  - const int vals[] -> The values to reduce
+//  - long len -> The length of the value array
+//  - int n_threads -> The number of threads to use
+wide_result wide_reduce(wide_op op, const int vals[], long len, int n_threads);
+
+#endif
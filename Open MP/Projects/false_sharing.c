@@ -0,0 +1,141 @@
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "bench.h"
+#include "padded.h"
+
+// double packed_accumulate() -> Has every thread add to its own slot of a packed long array,
+//  the way synchronization.c and filter.c used to keep per thread state
+//
+// INPUTS
+//  - long iterations -> How many times each thread updates its slot
+//  - int n_threads -> The number of threads
+double packed_accumulate(long iterations, int n_threads)
+{
+    long *slots = calloc(n_threads, sizeof(long));
+
+    double start = omp_get_wtime();
+#pragma omp parallel num_threads(n_threads)
+    {
+        // volatile so every update goes to memory instead of a register
+        volatile long *slot = &slots[omp_get_thread_num()];
+        for (long i = 0; i < iterations; i++)
+        {
+            *slot += i;
+        }
+    }
+    double time = omp_get_wtime() - start;
+
+    free(slots);
+    return time;
+}
+
+// double padded_accumulate() -> The same as packed_accumulate() but with one cache line per slot
+//
+// INPUTS
+//  - long iterations -> How many times each thread updates its slot
+//  - int n_threads -> The number of threads
+double padded_accumulate(long iterations, int n_threads)
+{
+    padded_long *slots = padded_calloc(n_threads, sizeof(padded_long));
+
+    double start = omp_get_wtime();
+#pragma omp parallel num_threads(n_threads)
+    {
+        volatile long *slot = &slots[omp_get_thread_num()].value;
+        for (long i = 0; i < iterations; i++)
+        {
+            *slot += i;
+        }
+    }
+    double time = omp_get_wtime() - start;
+
+    free(slots);
+    return time;
+}
+
+int main(int argc, char *argv[])
+{
+    bench_config cfg;
+    bench_defaults(&cfg);
+    int opt;
+    while ((opt = getopt(argc, argv, BENCH_OPTIONS)) != -1)
+    {
+        if (!bench_option(opt, optarg, &cfg))
+        {
+            printf("Usage: false_sharing %s iterations \n", BENCH_USAGE);
+            return 1;
+        }
+    }
+    // Shift the arguments so the positional ones start at argv[1]
+    argc -= optind - 1;
+    argv += optind - 1;
+
+    if (argc != 2) {
+        printf("Invalid Arguments: please pass [options] and the number of iterations per thread \n");
+        return 1;
+    }
+    bench_setup(&cfg);
+
+    long iterations = atol(argv[1]);
+    double *packed_samples = malloc(cfg.reps * sizeof(double));
+    double *padded_samples = malloc(cfg.reps * sizeof(double));
+
+    // Open the CSV data file
+    FILE *fp;
+    fp = fopen("Data/false_sharing_data.csv", "w"); // Open for writing, overwriting if exists
+
+    if (fp == NULL)
+    {
+        printf("Error opening file!\n");
+        exit(1); // Exit with an error code
+    }
+
+    // Write header row
+    fprintf(fp, "Thread Count,Reps,Iterations,Slot Size");
+    bench_write_header(fp, "Packed");
+    bench_write_header(fp, "Padded");
+    fprintf(fp, ",Speedup");
+    bench_write_binding(fp, true);
+    fprintf(fp, "\n");
+
+    for (int t = 0; t < cfg.n_thread_counts; t++)
+    {
+        int n_threads = cfg.threads[t];
+
+        // Negative runs are the warm up runs and are not recorded
+        for (int rep = -cfg.warmup; rep < cfg.reps; rep++)
+        {
+            double packed_time = packed_accumulate(iterations, n_threads);
+            double padded_time = padded_accumulate(iterations, n_threads);
+
+            if (rep >= 0)
+            {
+                packed_samples[rep] = packed_time;
+                padded_samples[rep] = padded_time;
+            }
+        }
+
+        bench_stats packed = bench_summarize(packed_samples, cfg.reps);
+        bench_stats padded = bench_summarize(padded_samples, cfg.reps);
+        printf("Threads %d\n  Packed median: %lf\n  Padded median: %lf\n", n_threads, packed.median, padded.median);
+
+        // Write the data to the csv file
+        fprintf(fp, "%d,%d,%ld,%zu", n_threads, cfg.reps, iterations, sizeof(padded_long));
+        bench_write_stats(fp, packed);
+        bench_write_stats(fp, padded);
+        fprintf(fp, ",%lf", packed.median / padded.median);
+        bench_write_binding(fp, false);
+        fprintf(fp, "\n");
+    }
+
+    fclose(fp); // Close the file
+    printf("Data written to false_sharing_data.csv successfully\n");
+
+    free(packed_samples);
+    free(padded_samples);
+
+    return 0;
+}
@@ -6,14 +6,29 @@
 #include <stdbool.h>
 #include <assert.h>
 #include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+#include "arena.h"
+#include "bench.h"
+#include "buffer.h"
+#include "memo.h"
+#include "padded.h"
+#include "profile.h"
+#include "schedule.h"
+#include "steal.h"
+#include "scan.h"
 
 // bool filter_func() -> Returns whether an integer is even or not
 //
 // INPUTS
 //  - int x -> The integer we want to determine is even or not
+//
+// The counter is volatile so the compiler keeps the loop and the cost stays proportional to x
 bool filter_func(int x)
 {
-    int sum = 0;
+    volatile int sum = 0;
     for (int i = 0; i < x; i++)
     {
         sum += 1;
@@ -22,6 +37,21 @@ bool filter_func(int x)
     return sum % 2 == 0;
 }
 
+// The memo the memoized runs look filter_func() answers up in
+static memo filter_memo;
+
+// int filter_value() -> filter_func(x) as an int, so it can be memoized
+int filter_value(int x)
+{
+    return filter_func(x);
+}
+
+// bool memoized_filter_func() -> filter_func(x), looked up in filter_memo
+bool memoized_filter_func(int x)
+{
+    return memo_get(&filter_memo, x) != 0;
+}
+
 // int* serial_filter -> This function filters an array based on a predicate function and returns a new array
 //  with only elements that pass the predicate function. This function is not parallel.
 //
@@ -35,21 +65,9 @@ int *serial_filter(int *arr, int arr_len, int *out_len, bool (*predicate_func)(i
     // Start the timing clock
     double start = omp_get_wtime();
 
-    int result_len = 0;
-    // First we need to figure out the size of the resultant array
-    for (int i = 0; i < arr_len; i++)
-    {
-        if (predicate_func(arr[i]))
-        {
-            result_len++;
-        }
-    }
-
-    // Allocate the memory space for the result array
-    *out_len = result_len;
-    int *result = malloc(result_len * sizeof(int));
-
-    // Add the necessary elements to the resultant array
+    // Write matches straight into an array big enough for every element, so the
+    // predicate only runs once per element, then give back the unused tail
+    int *result = malloc((size_t)arr_len * sizeof(int));
     int pos = 0;
     for (int i = 0; i < arr_len; i++)
     {
@@ -60,6 +78,13 @@ int *serial_filter(int *arr, int arr_len, int *out_len, bool (*predicate_func)(i
         }
     }
 
+    *out_len = pos;
+    int *shrunk = realloc(result, (size_t)(pos > 0 ? pos : 1) * sizeof(int));
+    if (shrunk != NULL)
+    {
+        result = shrunk;
+    }
+
     // End the timing clock
     double end = omp_get_wtime();
     double time_diff = end - start;
@@ -71,87 +96,120 @@ int *serial_filter(int *arr, int arr_len, int *out_len, bool (*predicate_func)(i
     return result;
 }
 
+// long scan_counts() -> Exclusive scan of the padded per thread counts into offsets
+//
+// INPUTS
+//  - const padded_int counts[] -> The number of matches each thread found
+//  - long offsets[] -> Where each thread should start writing its matches
+//  - int n_threads -> The number of threads (and counts)
+//  - arena* scratch -> Where the packed counts come from, or NULL to use malloc
+//
+// Returns the total number of matches
+long scan_counts(const padded_int counts[], long offsets[], int n_threads, arena *scratch)
+{
+    // The scan wants contiguous input, so pull the counts out of their cache lines first
+    int *packed = arena_alloc(scratch, (n_threads > 0 ? n_threads : 1) * sizeof(int));
+    for (int i = 0; i < n_threads; i++)
+    {
+        packed[i] = counts[i].value;
+    }
+
+    long total = exclusive_scan(packed, offsets, n_threads, SCAN_SERIAL, 1);
+    arena_release(scratch, packed);
+    return total;
+}
+
 // int* parallel_filter -> This function filters an array based on a predicate function and returns a new array
-//  with only the elements that return true from the original array. This function is parallel
+//  with only the elements that return true from the original array. This function is parallel.
+//  Its offsets are per thread, so both loops must hand every thread the same contiguous block and
+//  always use schedule(static) whatever schedule the driver was given
 //
 // INPUTS
 //  - int* arr -> A pointer to the original array of elements
 //  - int arr_len -> The length of the original array
 //  - int* out_len -> The length of the output array
 //  - int (*predicate_func)(int x) -> A function pointer to the predicate function
-int *parallel_filter(int *arr, int arr_len, int *out_len, bool (*predicate_func)(int x), int n_threads, double *time)
+//  - arena* scratch -> Where the counts, offsets and result come from, or NULL to use malloc.
+//      With an arena the result lives until the next arena_reset() and must not be freed
+int *parallel_filter(int *arr, int arr_len, int *out_len, bool (*predicate_func)(int x), int n_threads, arena *scratch, double *time)
 {
-    int *counts;
-
     // Start the timing clock
     double start = omp_get_wtime();
 
+    // One cache line per thread so the counts do not false share
+    padded_int *counts = scratch != NULL ? arena_alloc(scratch, n_threads * sizeof(padded_int))
+                                         : padded_calloc(n_threads, sizeof(padded_int));
+    memset(counts, 0, n_threads * sizeof(padded_int));
+
 // First we need to figure out how long the output array is going to be
 // Since we cannot dynamically adjust an array within a parallel region
 // without causing weird conditions
+    profile_region_begin("filter:count");
 #pragma omp parallel num_threads(n_threads)
     {
+        profile_thread_begin();
         int tid = omp_get_thread_num();
         int local_count = 0;
+        profile_chunks chunks = PROFILE_CHUNKS_INIT;
 
 // Iterate through the array and check how many times the predicate function returns true
 // for the elements that the thread looks at
-#pragma omp for schedule(static)
+#pragma omp for schedule(static) nowait
         for (int i = 0; i < arr_len; i++)
         {
+            profile_chunk_next(&chunks, i);
             if (predicate_func(arr[i]))
             {
                 local_count++;
             }
         }
-
-// Allocate memoery for an array called counts
-// This will hold the number of predicate true responses that each thread got
-#pragma omp single
-        {
-            counts = calloc(n_threads, sizeof(int));
-        }
+        profile_chunk_done(&chunks);
 
         // Set the corresponding predicate function count to each
         // thread in the count list
-        counts[tid] = local_count;
+        counts[tid].value = local_count;
+        profile_thread_end();
     }
+    profile_region_end();
 
     // Now we need to calculate the offsets for the different threads
     // That is - which indices each thread can put the result of their predicate funcitons in
-    int *offsets = malloc((n_threads + 1) * sizeof(int));
-
-    // The first thread should start inserting its results at the first index
-    offsets[0] = 0;
-    // Calculate the index offset of each thread
-    for (int i = 0; i < n_threads; i++)
-    {
-        offsets[i + 1] = offsets[i] + counts[i];
-    }
+    // This is an exclusive scan over the counts, so the first thread starts at index 0.
+    // The total lands in the final index of the offsets array
+    double offsets_start = omp_get_wtime();
+    long *offsets = arena_alloc(scratch, (n_threads + 1) * sizeof(long));
+    offsets[n_threads] = scan_counts(counts, offsets, n_threads, scratch);
 
     // Set the length of the resulting array
-    // This will be whatever is in the final index of the offsets array
     *out_len = offsets[n_threads];
 
     // Instantiate the result array
-    int *result = malloc((*out_len) * sizeof(int));
+    int *result = arena_alloc(scratch, (size_t)(*out_len) * sizeof(int));
+    profile_span("offsets", offsets_start, omp_get_wtime(), -1, -1);
 
 // Now we want to fill the resulting array in parallel
+    profile_region_begin("filter:fill");
 #pragma omp parallel num_threads(n_threads)
     {
+        profile_thread_begin();
         int tid = omp_get_thread_num();
-        int pos = offsets[tid];
+        long pos = offsets[tid];
+        profile_chunks chunks = PROFILE_CHUNKS_INIT;
 
-#pragma omp for schedule(static)
+#pragma omp for schedule(static) nowait
         for (int i = 0; i < arr_len; i++)
         {
+            profile_chunk_next(&chunks, i);
             if (predicate_func(arr[i]))
             {
                 result[pos] = arr[i];
                 pos++;
             }
         }
+        profile_chunk_done(&chunks);
+        profile_thread_end();
     }
+    profile_region_end();
 
     // End the timing clock
     double end = omp_get_wtime();
@@ -161,25 +219,234 @@ int *parallel_filter(int *arr, int arr_len, int *out_len, bool (*predicate_func)
     *time = time_diff;
 
     // Free up the space from the arrays
-    free(counts);
-    free(offsets);
+    arena_release(scratch, counts);
+    arena_release(scratch, offsets);
 
     // Return the resulting array
     return result;
 }
 
+// mask_words -> What mask_words_body() needs to fill in part of the single pass filter's mask
+typedef struct
+{
+    const int *arr;
+    int arr_len;
+    bool (*predicate_func)(int x);
+    uint64_t *mask;
+    int *word_counts;
+} mask_words;
+
+// void mask_words_body() -> Evaluates the predicate for every element of the 64 element words
+//  [begin, end), setting one mask bit per match and counting the matches in each word
+void mask_words_body(long begin, long end, void *ctx)
+{
+    mask_words *words = ctx;
+    for (long w = begin; w < end; w++)
+    {
+        long base = w * 64;
+        int width = words->arr_len - base < 64 ? (int)(words->arr_len - base) : 64;
+        uint64_t bits = 0;
+        for (int b = 0; b < width; b++)
+        {
+            if (words->predicate_func(words->arr[base + b]))
+            {
+                bits |= (uint64_t)1 << b;
+            }
+        }
+        words->mask[w] = bits;
+        words->word_counts[w] = __builtin_popcountll(bits);
+    }
+}
+
+// int* parallel_filter_compact -> A single pass version of parallel_filter(). The predicate is evaluated
+//  once per element and the answer is recorded as one bit in a mask, 64 elements to a word, along with
+//  the number of matches in each word. An exclusive scan over the word counts gives every word its
+//  output offset, and the matches are then scattered by walking the set bits of each word. Because
+//  the offsets are per word rather than per thread, the predicate loop can use any schedule (set with
+//  schedule_apply(), where one iteration is one 64 element word), including work stealing. The output is in the same order as
+//  the input, like parallel_filter()
+//
+// INPUTS
+//  - int* arr -> A pointer to the original array of elements
+//  - int arr_len -> The length of the original array
+//  - int* out_len -> The length of the output array
+//  - int (*predicate_func)(int x) -> A function pointer to the predicate function
+//  - arena* scratch -> Where the mask, counts, offsets and result come from, or NULL to use malloc
+int *parallel_filter_compact(int *arr, int arr_len, int *out_len, bool (*predicate_func)(int x), int n_threads, arena *scratch, double *time)
+{
+    // Start the timing clock
+    double start = omp_get_wtime();
+
+    // One bit per element. An iteration owns a whole 64 bit word so no two threads write the same word
+    long n_words = ((long)arr_len + 63) / 64;
+    uint64_t *mask = arena_alloc(scratch, n_words * sizeof(uint64_t));
+    int *word_counts = arena_alloc(scratch, n_words * sizeof(int));
+    long *word_offsets = arena_alloc(scratch, n_words * sizeof(long));
+
+    // Evaluate the predicate exactly once per element
+    mask_words words = {arr, arr_len, predicate_func, mask, word_counts};
+    const schedule_policy *policy = schedule_current();
+    if (policy->steal)
+    {
+        steal_for(n_words, policy->chunk, mask_words_body, &words, n_threads);
+    }
+    else
+    {
+        profile_region_begin("filter_compact:mask");
+#pragma omp parallel num_threads(n_threads)
+        {
+            profile_thread_begin();
+            profile_chunks chunks = PROFILE_CHUNKS_INIT;
+#pragma omp for schedule(runtime) nowait
+            for (long w = 0; w < n_words; w++)
+            {
+                profile_chunk_next(&chunks, w);
+                mask_words_body(w, w + 1, &words);
+            }
+            profile_chunk_done(&chunks);
+            profile_thread_end();
+        }
+        profile_region_end();
+    }
+
+    // Exclusive scan of the counts and allocation of the output
+    double scan_start = omp_get_wtime();
+    *out_len = exclusive_scan(word_counts, word_offsets, n_words, SCAN_BLOCKED, n_threads);
+    int *result = arena_alloc(scratch, (size_t)(*out_len) * sizeof(int));
+    profile_span("offsets", scan_start, omp_get_wtime(), -1, -1);
+
+// Scatter every word's matches starting at its offset
+    profile_region_begin("filter_compact:scatter");
+#pragma omp parallel num_threads(n_threads)
+    {
+        profile_thread_begin();
+#pragma omp for schedule(static) nowait
+        for (long w = 0; w < n_words; w++)
+        {
+            uint64_t bits = mask[w];
+            long pos = word_offsets[w];
+            while (bits != 0)
+            {
+                result[pos] = arr[w * 64 + __builtin_ctzll(bits)];
+                pos++;
+                bits &= bits - 1;
+            }
+        }
+        profile_thread_end();
+    }
+    profile_region_end();
+
+    // End the timing clock
+    double end = omp_get_wtime();
+    double time_diff = end - start;
+
+    printf("Parallel (single pass):\n  Time: %lf\n", time_diff);
+    *time = time_diff;
+
+    arena_release(scratch, mask);
+    arena_release(scratch, word_counts);
+    arena_release(scratch, word_offsets);
+
+    return result;
+}
+
+// filter_trial -> The sample the schedule auto tuner runs parallel_filter_compact() on
+typedef struct
+{
+    int *sample;
+    int len;
+    int n_threads;
+} filter_trial;
+
+// double time_filter_trial() -> Runs parallel_filter_compact() once on the sample
+double time_filter_trial(void *ctx)
+{
+    filter_trial *trial = ctx;
+    int out_len;
+    double time;
+
+    free(parallel_filter_compact(trial->sample, trial->len, &out_len, filter_func, trial->n_threads, NULL, &time));
+    return time;
+}
+
 int main(int argc, char *argv[])
 {
-    if (argc != 2) {
-        printf("Invalid Arguments: please pass num_threads \n");
+    // -s picks the single pass kernel's schedule, e.g. -s dynamic,4 or -s auto.
+    // -m makes the parallel kernels malloc their scratch and results every run instead of
+    // taking them from an arena that is reused across runs.
+    // -M picks how filter_func() answers are memoized (off, table, cache or auto).
+    // The other options configure the benchmark harness (see bench.h)
+    schedule_policy policy = {omp_sched_static, 0, false};
+    bool tune = false;
+    bool use_malloc = false;
+    memo_mode memo_setting = MEMO_AUTO;
+    bench_config cfg;
+    bench_defaults(&cfg);
+    int opt;
+    while ((opt = getopt(argc, argv, "s:mM:" BENCH_OPTIONS)) != -1)
+    {
+        if (opt == 'm')
+        {
+            use_malloc = true;
+            continue;
+        }
+        bool ok;
+        if (opt == 's')
+        {
+            ok = schedule_option(optarg, &policy, &tune);
+        }
+        else if (opt == 'M')
+        {
+            ok = memo_parse(optarg, &memo_setting);
+        }
+        else
+        {
+            ok = bench_option(opt, optarg, &cfg);
+        }
+        if (!ok)
+        {
+            printf("Invalid Arguments: -s takes static, dynamic, guided or steal (with an optional ,chunk) or auto, -M takes off, table, cache or auto \n");
+            printf("Usage: filter [-s schedule] [-m] [-M memo] %s length [input file] \n", BENCH_USAGE);
+            return 1;
+        }
+    }
+    // Shift the arguments so the positional ones start at argv[1]
+    argc -= optind - 1;
+    argv += optind - 1;
+
+    if (argc != 2 && argc != 3) {
+        printf("Invalid Arguments: please pass [options] array length (and optionally a binary input file) \n");
         return 1;
     }
+    bench_setup(&cfg);
+
     // Create the array using the command line arg
     int arr_len = atoi(argv[1]);
-    int arr[arr_len];
-    for (int i = 0; i < arr_len; i++)
+
+    // The input either comes from a memory mapped binary file or is 0..arr_len-1 on the heap
+    int_buffer arr;
+    if (argc == 3)
     {
-        arr[i] = i;
+        if (!buffer_map_file(argv[2], &arr))
+        {
+            printf("Error mapping input file %s!\n", argv[2]);
+            exit(1);
+        }
+        // A length of 0 (or one longer than the file) means use the whole file
+        if (arr_len > 0 && (size_t)arr_len < arr.len)
+        {
+            arr.len = arr_len;
+        }
+        arr_len = arr.len;
+    }
+    else
+    {
+        arr = buffer_alloc(arr_len, omp_get_max_threads());
+#pragma omp parallel for schedule(static)
+        for (int i = 0; i < arr_len; i++)
+        {
+            arr.data[i] = i;
+        }
     }
 
     // Open the CSV data file
@@ -192,38 +459,179 @@ int main(int argc, char *argv[])
         exit(1); // Exit with an error code
     }
 
-    // Write header row
-    fprintf(fp, "Thread Count,Trial,Serial Time,Parallel Time, Array Size\n");
+    // Write header row. Every row summarizes the timed runs at one thread count.
+    // Parallel is the two pass kernel and Single Pass is parallel_filter_compact()
+    fprintf(fp, "Thread Count,Reps,Array Size");
+    bench_write_header(fp, "Serial");
+    bench_write_header(fp, "Parallel");
+    bench_write_header(fp, "Single Pass");
+    fprintf(fp, ",Speedup,Single Pass Speedup,Copy Time,Schedule,Chunk Size,Allocator,Allocations Avoided,Page Faults,Memo,Memo Hit Rate");
+    bench_write_binding(fp, true);
+    fprintf(fp, "\n");
+
+    // The filters never write to their input, but they get a private heap copy so that
+    // a memory mapped input is paged in before the timed region and the cost is recorded
+    int_buffer work = buffer_alloc(arr_len, omp_get_max_threads());
+    double *serial_samples = malloc(cfg.reps * sizeof(double));
+    double *parallel_samples = malloc(cfg.reps * sizeof(double));
+    double *compact_samples = malloc(cfg.reps * sizeof(double));
+    double *copy_samples = malloc(cfg.reps * sizeof(double));
+
+    // Both parallel kernels' scratch and results come from one arena that is reset every run.
+    // Its first guess is room for two complete results, and it grows if a run needs more
+    arena scratch_arena = arena_create(use_malloc ? 0 : 2 * (size_t)arr_len * sizeof(int), omp_get_max_threads());
+    arena *scratch = use_malloc ? NULL : &scratch_arena;
+
+    // The serial baseline does not depend on the thread count, so it is timed once.
+    // Negative runs are the warm up runs and are not recorded
+    int serial_out_len = 0;
+    int *serial_filtered = NULL;
+    buffer_copy(&work, &arr, omp_get_max_threads());
+    for (int rep = -cfg.warmup; rep < cfg.reps; rep++)
+    {
+        double serial_time;
+        free(serial_filtered);
+        serial_filtered = serial_filter(work.data, arr_len, &serial_out_len, filter_func, &serial_time);
+        if (rep >= 0)
+        {
+            serial_samples[rep] = serial_time;
+        }
+    }
+    bench_stats serial = bench_summarize(serial_samples, cfg.reps);
 
-    for (int n_threads = 1; n_threads < 9; n_threads++)
+    schedule_apply(&policy);
+    for (int t = 0; t < cfg.n_thread_counts; t++)
     {
-        for (int trial = 1; trial < 4; trial++)
+        int n_threads = cfg.threads[t];
+
+        // The best schedule depends on the thread count, so tune for every one
+        if (tune)
         {
+            // The predicate costs more for later elements, so the sample takes every stride'th
+            // element to cover the whole input instead of just its cheap start
+            filter_trial sample = {work.data, arr_len < SCHEDULE_SAMPLE_LEN ? arr_len : SCHEDULE_SAMPLE_LEN, n_threads};
+            long stride = arr_len / (sample.len > 0 ? sample.len : 1);
+            for (int i = 0; i < sample.len; i++)
+            {
+                work.data[i] = arr.data[i * stride];
+            }
+            policy = schedule_autotune(time_filter_trial, &sample);
+        }
+
+        // Decide once per thread count whether memoizing pays. Auto stays off when a call is
+        // cheaper than a lookup or the elements rarely repeat, so the plain predicate runs
+        memo_mode mode = memo_setting == MEMO_AUTO ? memo_choose(filter_value, arr.data, arr_len, n_threads) : memo_setting;
+        bool (*predicate)(int x) = mode == MEMO_OFF ? filter_func : memoized_filter_func;
+        double hit_rate = 0;
+
+        // Minor page faults over the timed runs, measured rather than estimated. Compare a run
+        // with -m to see how many the arena saves
+        long faults = 0;
+        long allocations_avoided = scratch_arena.allocations_avoided;
+
+        for (int rep = -cfg.warmup; rep < cfg.reps; rep++)
+        {
+            struct rusage before;
+            struct rusage after;
             int parallel_out_len;
-            int serial_out_len;
+            int compact_out_len;
 
             double parallel_time;
-            double serial_time;
+            double compact_time;
+            double copy_time = buffer_copy(&work, &arr, n_threads);
+
+            // The warm up runs size the arena, so only the timed runs count towards what it saved
+            if (rep == 0)
+            {
+                allocations_avoided = scratch_arena.allocations_avoided;
+            }
+
+            // Both kernels share one memo, and each is charged the full cost of building it
+            double build_time = 0;
+            if (mode != MEMO_OFF)
+            {
+                double build_start = omp_get_wtime();
+                memo_create(&filter_memo, mode, filter_value, work.data, arr_len, n_threads);
+                build_time = omp_get_wtime() - build_start;
+            }
+
+            getrusage(RUSAGE_SELF, &before);
+            int *parallel_filtered = parallel_filter(work.data, arr_len, &parallel_out_len, predicate, n_threads, scratch, &parallel_time);
+            int *compact_filtered = parallel_filter_compact(work.data, arr_len, &compact_out_len, predicate, n_threads, scratch, &compact_time);
+            getrusage(RUSAGE_SELF, &after);
+            parallel_time += build_time;
+            compact_time += build_time;
 
-            int *parallel_filtered = parallel_filter(arr, arr_len, &parallel_out_len, filter_func, n_threads, &parallel_time);
-            int *serial_filtered = serial_filter(arr, arr_len, &serial_out_len, filter_func, &serial_time);
+            // The two pass kernel looks every element up twice and the single pass one once
+            if (mode != MEMO_OFF)
+            {
+                hit_rate = memo_hit_rate(&filter_memo, 3 * (long)arr_len);
+                memo_free(&filter_memo);
+            }
 
-            // Check that the two arrays are equal
+            // Check that the arrays are equal
             assert(parallel_out_len == serial_out_len);
-            assert(memcmp(parallel_filtered, serial_filtered, parallel_out_len * sizeof(int)) == 0);
-            printf("Assertion 1 passed: The two results are the same\n\n");
+            assert(memcmp(parallel_filtered, serial_filtered, (size_t)parallel_out_len * sizeof(int)) == 0);
+            assert(compact_out_len == serial_out_len);
+            assert(memcmp(compact_filtered, serial_filtered, (size_t)compact_out_len * sizeof(int)) == 0);
 
-            // Write the data to the csv file
-            fprintf(fp, "%d,%d,%lf,%lf,%d\n", n_threads, trial, serial_time, parallel_time, arr_len);
+            if (rep >= 0)
+            {
+                parallel_samples[rep] = parallel_time;
+                compact_samples[rep] = compact_time;
+                copy_samples[rep] = copy_time;
+                faults += after.ru_minflt - before.ru_minflt;
+            }
 
-            // Free up the the memory from the two resultant arrays
-            free(parallel_filtered);
-            free(serial_filtered);
+            // Free up the the memory from the two resultant arrays, or hand the arena back
+            if (scratch != NULL)
+            {
+                arena_reset(scratch);
+            }
+            else
+            {
+                free(parallel_filtered);
+                free(compact_filtered);
+            }
         }
+        allocations_avoided = scratch_arena.allocations_avoided - allocations_avoided;
+        printf("Assertion 1 passed: The two results are the same\n");
+        printf("Assertion 2 passed: The single pass result is the same\n");
+
+        bench_stats parallel = bench_summarize(parallel_samples, cfg.reps);
+        bench_stats compact = bench_summarize(compact_samples, cfg.reps);
+        bench_stats copy = bench_summarize(copy_samples, cfg.reps);
+        printf("%d threads\n  Serial median: %lf\n  Parallel median: %lf (p95 %lf)\n  Single pass median: %lf (p95 %lf)\n",
+               n_threads, serial.median, parallel.median, parallel.p95, compact.median, compact.p95);
+        printf("Single pass speedup over two pass: %lf\n", parallel.median / compact.median);
+        printf("Page faults per run: %ld (%s, %ld allocations avoided)\n\n", faults / cfg.reps,
+               use_malloc ? "malloc" : "arena", allocations_avoided);
+
+        // Write the data to the csv file
+        fprintf(fp, "%d,%d,%d", n_threads, cfg.reps, arr_len);
+        bench_write_stats(fp, serial);
+        bench_write_stats(fp, parallel);
+        bench_write_stats(fp, compact);
+        fprintf(fp, ",%lf,%lf,%lf,%s,%d", serial.median / parallel.median, parallel.median / compact.median,
+                copy.median, schedule_name(&policy), policy.chunk);
+        fprintf(fp, ",%s,%ld,%ld", use_malloc ? "malloc" : "arena", allocations_avoided, faults / cfg.reps);
+        fprintf(fp, ",%s,%lf", memo_name(mode), hit_rate);
+        bench_write_binding(fp, false);
+        fprintf(fp, "\n");
     }
 
     fclose(fp); // Close the file
-    printf("Data written to people.csv successfully\n");
+    printf("Data written to filter_data.csv successfully\n");
+    profile_write_report("Data/profile_data");
+
+    free(serial_filtered);
+    free(serial_samples);
+    free(parallel_samples);
+    free(compact_samples);
+    free(copy_samples);
+    arena_destroy(&scratch_arena);
+    buffer_free(&work);
+    buffer_free(&arr);
 
     return 0;
-}
\ No newline at end of file
+}
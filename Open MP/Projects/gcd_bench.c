@@ -0,0 +1,189 @@
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <unistd.h>
+
+#include "bench.h"
+#include "buffer.h"
+#include "reduction.h"
+
+// int scalar_gcd_reduce() -> Reduces vals one element at a time with the given gcd function,
+//  the same way serial_reduce() in reduce.c does
+//
+// INPUTS
+//  - int (*gcd_func)(int a, int b) -> The gcd implementation to use
+//  - const int vals[] -> The values to reduce
+//  - int len -> The length of the value array
+//  - double* time -> Set to the time the reduction took
+int scalar_gcd_reduce(int (*gcd_func)(int a, int b), const int vals[], int len, double *time)
+{
+    double start = omp_get_wtime();
+
+    int result = 0;
+    for (int i = 0; i < len; i++)
+    {
+        result = gcd_func(result, vals[i]);
+    }
+
+    *time = omp_get_wtime() - start;
+    return result;
+}
+
+// int default_factor() -> The largest product of the first few primes (2, 6, 30, 210, ...) no
+//  larger than the square root of MAX_VAL, so the values keep a gcd above 1 and still take
+//  enough different multiples of it to exercise the kernels
+int default_factor(int MAX_VAL)
+{
+    const int primes[] = {2, 3, 5, 7, 11, 13, 17, 19, 23};
+    long factor = 1;
+    for (int i = 0; i < 9 && factor * primes[i] * factor * primes[i] <= MAX_VAL; i++)
+    {
+        factor *= primes[i];
+    }
+
+    return (int)factor;
+}
+
+int main(int argc, char *argv[])
+{
+    bench_config cfg;
+    bench_defaults(&cfg);
+    int opt;
+    while ((opt = getopt(argc, argv, BENCH_OPTIONS)) != -1)
+    {
+        if (!bench_option(opt, optarg, &cfg))
+        {
+            printf("Usage: gcd_bench %s length MAX_VAL [factor] \n", BENCH_USAGE);
+            return 1;
+        }
+    }
+    // Shift the arguments so the positional ones start at argv[1]
+    argc -= optind - 1;
+    argv += optind - 1;
+
+    if (argc != 3 && argc != 4) {
+        printf("Invalid Arguments: please pass [options] length and MAX_VAL (and optionally a common factor, 1 for plain random values) \n");
+        return 1;
+    }
+    bench_setup(&cfg);
+
+    int len = atoi(argv[1]);
+    int MAX_VAL = atoi(argv[2]);
+    // Random values almost always have a gcd of 1 after a handful of elements, and every kernel
+    // stops there, so every value is made a multiple of factor to keep the gcd from collapsing
+    int factor = argc == 4 ? atoi(argv[3]) : default_factor(MAX_VAL);
+    if (factor < 1 || factor > MAX_VAL)
+    {
+        printf("Invalid Arguments: factor must be between 1 and MAX_VAL \n");
+        return 1;
+    }
+
+    int_buffer vals = buffer_alloc(len, omp_get_max_threads());
+    bench_fill(&cfg, vals.data, len, MAX_VAL / factor);
+#pragma omp parallel for schedule(static)
+    for (int i = 0; i < len; i++)
+    {
+        vals.data[i] *= factor;
+    }
+    const reduce_operator *op = reduce_find("gcd");
+    double *loop_samples = malloc(cfg.reps * sizeof(double));
+    double *binary_samples = malloc(cfg.reps * sizeof(double));
+    double *hybrid_samples = malloc(cfg.reps * sizeof(double));
+    double *batch_samples = malloc(cfg.reps * sizeof(double));
+    double *parallel_samples = malloc(cfg.reps * sizeof(double));
+
+    // Open the CSV data file
+    FILE *fp;
+    fp = fopen("Data/gcd_data.csv", "w"); // Open for writing, overwriting if exists
+
+    if (fp == NULL)
+    {
+        printf("Error opening file!\n");
+        exit(1); // Exit with an error code
+    }
+
+    // Write header row. Loop, Binary, Hybrid and Batch run on one thread whatever the thread
+    // count, Parallel is reduce_run() with the gcd operator
+    fprintf(fp, "Thread Count,Reps,Array Size,MAX_VAL,Factor,Distribution");
+    bench_write_header(fp, "Loop");
+    bench_write_header(fp, "Binary");
+    bench_write_header(fp, "Hybrid");
+    bench_write_header(fp, "Batch");
+    bench_write_header(fp, "Parallel");
+    fprintf(fp, ",Speedup,Result");
+    bench_write_binding(fp, true);
+    fprintf(fp, "\n");
+
+    for (int t = 0; t < cfg.n_thread_counts; t++)
+    {
+        int n_threads = cfg.threads[t];
+        int result = 0;
+
+        // Negative runs are the warm up runs and are not recorded
+        for (int rep = -cfg.warmup; rep < cfg.reps; rep++)
+        {
+            double loop_time;
+            double binary_time;
+            double hybrid_time;
+
+            result = scalar_gcd_reduce(gcd_loop, vals.data, len, &loop_time);
+            int binary_result = scalar_gcd_reduce(gcd_binary, vals.data, len, &binary_time);
+            int hybrid_result = scalar_gcd_reduce(gcd, vals.data, len, &hybrid_time);
+
+            double start = omp_get_wtime();
+            int batch_result = gcd_reduce_batch(vals.data, len, 0);
+            double batch_time = omp_get_wtime() - start;
+
+            start = omp_get_wtime();
+            int parallel_result = reduce_run(op, vals.data, len, n_threads);
+            double parallel_time = omp_get_wtime() - start;
+
+            // Check that every implementation agrees with the original loop
+            assert(binary_result == result);
+            assert(hybrid_result == result);
+            assert(batch_result == result);
+            assert(parallel_result == result);
+
+            if (rep >= 0)
+            {
+                loop_samples[rep] = loop_time;
+                binary_samples[rep] = binary_time;
+                hybrid_samples[rep] = hybrid_time;
+                batch_samples[rep] = batch_time;
+                parallel_samples[rep] = parallel_time;
+            }
+        }
+
+        bench_stats loop = bench_summarize(loop_samples, cfg.reps);
+        bench_stats binary = bench_summarize(binary_samples, cfg.reps);
+        bench_stats hybrid = bench_summarize(hybrid_samples, cfg.reps);
+        bench_stats batch = bench_summarize(batch_samples, cfg.reps);
+        bench_stats parallel = bench_summarize(parallel_samples, cfg.reps);
+        printf("%d threads (gcd %d)\n  Loop median: %lf\n  Binary median: %lf\n  Hybrid median: %lf\n  Batch median: %lf\n  Parallel median: %lf\n",
+               n_threads, result, loop.median, binary.median, hybrid.median, batch.median, parallel.median);
+
+        // Write the data to the csv file. Speedup is the parallel reduction over the original loop
+        fprintf(fp, "%d,%d,%d,%d,%d,%s", n_threads, cfg.reps, len, MAX_VAL, factor, rng_name(&cfg.dist));
+        bench_write_stats(fp, loop);
+        bench_write_stats(fp, binary);
+        bench_write_stats(fp, hybrid);
+        bench_write_stats(fp, batch);
+        bench_write_stats(fp, parallel);
+        fprintf(fp, ",%lf,%d", loop.median / parallel.median, result);
+        bench_write_binding(fp, false);
+        fprintf(fp, "\n");
+    }
+
+    fclose(fp); // Close the file
+    printf("Data written to gcd_data.csv successfully\n");
+
+    free(loop_samples);
+    free(binary_samples);
+    free(hybrid_samples);
+    free(batch_samples);
+    free(parallel_samples);
+    buffer_free(&vals);
+
+    return 0;
+}
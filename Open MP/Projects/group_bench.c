@@ -0,0 +1,230 @@
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+
+#include "bench.h"
+#include "buffer.h"
+#include "group.h"
+#include "reduction.h"
+#include "rng.h"
+
+// The most key cardinalities one run can sweep over
+#define MAX_CARDINALITIES 16
+
+// void check_groups() -> Checks a grouped result against the reference computed with a dense
+//  array indexed by key
+//
+// INPUTS
+//  - const group_result* result -> The result to check
+//  - const int expected[] -> expected[k] is the reduction of key k
+//  - const unsigned char present[] -> present[k] is whether key k occurs at all
+//  - long n_present -> The number of keys that occur
+void check_groups(const group_result *result, const int expected[], const unsigned char present[], long n_present)
+{
+    assert(result->n_groups == n_present);
+    for (long i = 0; i < result->n_groups; i++)
+    {
+        assert(present[result->keys[i]]);
+        assert(result->values[i] == expected[result->keys[i]]);
+    }
+}
+
+// bool parse_cardinalities() -> Parses a comma separated list of key counts, e.g. "16,4096,1000000"
+bool parse_cardinalities(const char *arg, int cardinalities[], int *n_cardinalities)
+{
+    int n = 0;
+    const char *p = arg;
+    while (*p != '\0')
+    {
+        char *end;
+        long cardinality = strtol(p, &end, 10);
+        if (end == p || cardinality < 1 || cardinality > 1 << 30 || n == MAX_CARDINALITIES)
+        {
+            return false;
+        }
+        cardinalities[n++] = (int)cardinality;
+        if (*end == ',')
+        {
+            end++;
+        }
+        else if (*end != '\0')
+        {
+            return false;
+        }
+        p = end;
+    }
+
+    *n_cardinalities = n;
+    return n > 0;
+}
+
+int main(int argc, char *argv[])
+{
+    bench_config cfg;
+    bench_defaults(&cfg);
+    int cardinalities[MAX_CARDINALITIES] = {16, 4096, 262144, 4194304};
+    int n_cardinalities = 4;
+    int opt;
+    while ((opt = getopt(argc, argv, BENCH_OPTIONS "c:")) != -1)
+    {
+        if (opt == 'c' ? !parse_cardinalities(optarg, cardinalities, &n_cardinalities) : !bench_option(opt, optarg, &cfg))
+        {
+            printf("Usage: group_bench %s [-c key counts e.g. 16,4096,1000000] length MAX_VAL [operator...] \n", BENCH_USAGE);
+            return 1;
+        }
+    }
+    // Shift the arguments so the positional ones start at argv[1]
+    argc -= optind - 1;
+    argv += optind - 1;
+
+    if (argc < 3) {
+        printf("Invalid Arguments: please pass [options] length and MAX_VAL, and optionally the operators to group by (add, mult, max, gcd) \n");
+        return 1;
+    }
+    bench_setup(&cfg);
+
+    long len = atol(argv[1]);
+    int MAX_VAL = atoi(argv[2]);
+    const char *default_ops[] = {"add", "mult", "max", "gcd"};
+    int n_ops = argc > 3 ? argc - 3 : 4;
+    const char **op_names = argc > 3 ? (const char **)argv + 3 : default_ops;
+    for (int o = 0; o < n_ops; o++)
+    {
+        if (reduce_find(op_names[o]) == NULL)
+        {
+            printf("Invalid Arguments: %s is not an operator \n", op_names[o]);
+            return 1;
+        }
+    }
+
+    int_buffer keys = buffer_alloc(len, omp_get_max_threads());
+    int_buffer vals = buffer_alloc(len, omp_get_max_threads());
+    // The values come from the next seed, so they are independent of the keys
+    bench_fill(&cfg, vals.data, len, MAX_VAL);
+    double *samples[4];
+    for (int s = 0; s < 4; s++)
+    {
+        samples[s] = malloc(cfg.reps * sizeof(double));
+    }
+
+    // Open the CSV data file
+    FILE *fp;
+    fp = fopen("Data/group_data.csv", "w"); // Open for writing, overwriting if exists
+
+    if (fp == NULL)
+    {
+        printf("Error opening file!\n");
+        exit(1); // Exit with an error code
+    }
+
+    // Write header row. Serial is the hash strategy on one thread, Parallel the strategy group_choose()
+    // picks (Auto Strategy), Hash and Partition force one or the other
+    fprintf(fp, "Thread Count,Reps,Array Size,Operator,Key Count,Groups,Key Distribution,Auto Strategy");
+    bench_write_header(fp, "Serial");
+    bench_write_header(fp, "Parallel");
+    bench_write_header(fp, "Hash");
+    bench_write_header(fp, "Partition");
+    fprintf(fp, ",Speedup");
+    bench_write_binding(fp, true);
+    fprintf(fp, "\n");
+
+    for (int c = 0; c < n_cardinalities; c++)
+    {
+        int cardinality = cardinalities[c];
+        rng_fill(&cfg.dist, cfg.seed + 1, keys.data, len, cardinality, omp_get_max_threads());
+        group_strategy chosen = group_choose(keys.data, len);
+
+        for (int o = 0; o < n_ops; o++)
+        {
+            const reduce_operator *op = reduce_find(op_names[o]);
+
+            // The reference: a dense array indexed by key, reduced in input order
+            int *expected = malloc(((size_t)cardinality + 1) * sizeof(int));
+            unsigned char *present = calloc((size_t)cardinality + 1, 1);
+            long n_present = 0;
+            for (long i = 0; i < len; i++)
+            {
+                int k = keys.data[i];
+                expected[k] = present[k] ? op->func(expected[k], vals.data[i]) : vals.data[i];
+                n_present += !present[k];
+                present[k] = 1;
+            }
+
+            // The serial baseline does not depend on the thread count, so it is timed once.
+            // Negative runs are the warm up runs and are not recorded
+            for (int rep = -cfg.warmup; rep < cfg.reps; rep++)
+            {
+                double start = omp_get_wtime();
+                group_result serial = group_reduce(op, keys.data, vals.data, len, GROUP_HASH, 1);
+                double serial_time = omp_get_wtime() - start;
+                check_groups(&serial, expected, present, n_present);
+                group_free(&serial);
+                if (rep >= 0)
+                {
+                    samples[0][rep] = serial_time;
+                }
+            }
+            bench_stats serial = bench_summarize(samples[0], cfg.reps);
+
+            for (int t = 0; t < cfg.n_thread_counts; t++)
+            {
+                int n_threads = cfg.threads[t];
+                group_strategy strategies[3] = {GROUP_AUTO, GROUP_HASH, GROUP_PARTITION};
+
+                for (int rep = -cfg.warmup; rep < cfg.reps; rep++)
+                {
+                    for (int s = 0; s < 3; s++)
+                    {
+                        double start = omp_get_wtime();
+                        group_result result = group_reduce(op, keys.data, vals.data, len, strategies[s], n_threads);
+                        double time = omp_get_wtime() - start;
+
+                        // Every strategy has to find every group with its exact reduction
+                        check_groups(&result, expected, present, n_present);
+                        group_free(&result);
+                        if (rep >= 0)
+                        {
+                            samples[s + 1][rep] = time;
+                        }
+                    }
+                }
+
+                bench_stats parallel = bench_summarize(samples[1], cfg.reps);
+                bench_stats hash = bench_summarize(samples[2], cfg.reps);
+                bench_stats partition = bench_summarize(samples[3], cfg.reps);
+                printf("%s over %d keys (%ld groups), %d threads\n  Serial median: %lf\n  Hash median: %lf\n  Partition median: %lf\n  Auto picks: %s\n",
+                       op->name, cardinality, n_present, n_threads, serial.median, hash.median, partition.median,
+                       group_name(chosen));
+
+                // Write the data to the csv file
+                fprintf(fp, "%d,%d,%ld,%s,%d,%ld,%s,%s", n_threads, cfg.reps, len, op->name, cardinality, n_present,
+                        rng_name(&cfg.dist), group_name(chosen));
+                bench_write_stats(fp, serial);
+                bench_write_stats(fp, parallel);
+                bench_write_stats(fp, hash);
+                bench_write_stats(fp, partition);
+                fprintf(fp, ",%lf", serial.median / parallel.median);
+                bench_write_binding(fp, false);
+                fprintf(fp, "\n");
+            }
+
+            free(expected);
+            free(present);
+        }
+    }
+
+    fclose(fp); // Close the file
+    printf("Data written to group_data.csv successfully\n");
+
+    for (int s = 0; s < 4; s++)
+    {
+        free(samples[s]);
+    }
+    buffer_free(&keys);
+    buffer_free(&vals);
+
+    return 0;
+}
@@ -0,0 +1,479 @@
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+#include <unistd.h>
+
+#include "bench.h"
+#include "locks.h"
+
+// Every LOCK_SAMPLE-th operation of each thread is timed. For the locks that can be split the
+// samples alternate between timing the whole operation and timing its acquire and release, so the
+// extra timer calls of a split sample never land in a whole operation time
+#define LOCK_SAMPLE 16
+
+// The most critical section lengths one run can sweep over
+#define MAX_LENGTHS 16
+
+// The locks compared. ATOMIC has no critical section to hold, it only runs at length 0
+typedef enum
+{
+    LOCK_CRITICAL,
+    LOCK_OMP,
+    LOCK_ATOMIC,
+    LOCK_TAS,
+    LOCK_TICKET,
+    LOCK_MCS,
+    LOCK_RW,
+    N_LOCKS
+} lock_kind;
+
+static const char *lock_names[N_LOCKS] = {"critical", "omp_lock", "atomic", "tas", "ticket", "mcs", "rw"};
+
+// shared_state -> The locks and the counter they protect
+typedef struct
+{
+    padded_long counter;
+    omp_lock_t omp;
+    tas_lock tas;
+    ticket_lock ticket;
+    mcs_lock mcs;
+    rw_lock rw;
+} shared_state;
+
+// void work() -> Takes time proportional to units, without touching shared data
+void work(int units)
+{
+    volatile int sum = 0;
+    for (int i = 0; i < units; i++)
+    {
+        sum += 1;
+    }
+}
+
+// bool is_read() -> Whether operation i of a thread only reads the counter, for read_percent
+//  percent of the operations. Spread by a multiplicative hash so reads and writes interleave
+bool is_read(long i, int read_percent)
+{
+    return (unsigned)((unsigned long)i * 2654435761u % 100) < (unsigned)read_percent;
+}
+
+// void acquire() / release() -> Take and return the lock of the given kind. Reads take the rw
+//  lock shared, every other lock is exclusive either way
+void acquire(lock_kind kind, shared_state *s, mcs_node *node, bool read)
+{
+    switch (kind)
+    {
+    case LOCK_OMP:
+        omp_set_lock(&s->omp);
+        break;
+    case LOCK_TAS:
+        tas_acquire(&s->tas);
+        break;
+    case LOCK_TICKET:
+        ticket_acquire(&s->ticket);
+        break;
+    case LOCK_MCS:
+        mcs_acquire(&s->mcs, node);
+        break;
+    case LOCK_RW:
+        if (read)
+        {
+            rw_acquire_read(&s->rw);
+        }
+        else
+        {
+            rw_acquire_write(&s->rw);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+void release(lock_kind kind, shared_state *s, mcs_node *node, bool read)
+{
+    switch (kind)
+    {
+    case LOCK_OMP:
+        omp_unset_lock(&s->omp);
+        break;
+    case LOCK_TAS:
+        tas_release(&s->tas);
+        break;
+    case LOCK_TICKET:
+        ticket_release(&s->ticket);
+        break;
+    case LOCK_MCS:
+        mcs_release(&s->mcs, node);
+        break;
+    case LOCK_RW:
+        if (read)
+        {
+            rw_release_read(&s->rw);
+        }
+        else
+        {
+            rw_release_write(&s->rw);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+// void critical_section() -> Reads or increments the counter, then holds the lock for length
+//  work units
+void critical_section(shared_state *s, int length, bool read)
+{
+    if (read)
+    {
+        volatile long seen = s->counter.value;
+        (void)seen;
+    }
+    else
+    {
+        s->counter.value++;
+    }
+    work(length);
+}
+
+// double contend() -> Has n_threads threads each run ops operations under the lock, and returns
+//  the wall time of the run
+//
+// INPUTS
+//  - lock_kind kind -> The lock to take
+//  - shared_state* s -> The locks and the counter, with the counter at 0
+//  - int n_threads -> The number of threads
+//  - long ops -> The operations each thread runs
+//  - int length -> The work units done holding the lock
+//  - int outside -> The work units done between operations, without the lock
+//  - int read_percent -> The percentage of operations that only read the counter
+//  - double acquire_times[] / release_times[] -> Set to the sampled acquire and release times,
+//      ops / LOCK_SAMPLE per thread, NAN where a sample timed the whole operation instead. All NAN
+//      for critical and atomic, which cannot be split
+//  - double operation_times[] -> Set to the sampled times of whole operations, acquire, critical
+//      section and release together, for every lock. NAN where a sample was split
+double contend(lock_kind kind, shared_state *s, int n_threads, long ops, int length, int outside, int read_percent,
+               double acquire_times[], double release_times[], double operation_times[])
+{
+    long samples = ops / LOCK_SAMPLE;
+    double start = 0;
+    double end = 0;
+
+#pragma omp parallel num_threads(n_threads)
+    {
+        int tid = omp_get_thread_num();
+        mcs_node node;
+        double *acquired = acquire_times + tid * samples;
+        double *released = release_times + tid * samples;
+        double *operations = operation_times + tid * samples;
+
+#pragma omp barrier
+#pragma omp single
+        start = omp_get_wtime();
+
+        for (long i = 0; i < ops; i++)
+        {
+            bool read = is_read(i, read_percent);
+            bool sampled = i % LOCK_SAMPLE == 0 && i / LOCK_SAMPLE < samples;
+            bool split = sampled && kind != LOCK_CRITICAL && kind != LOCK_ATOMIC && (i / LOCK_SAMPLE) % 2 == 1;
+            double t0 = sampled ? omp_get_wtime() : 0;
+            double t1 = 0;
+            double t2 = 0;
+
+            if (kind == LOCK_CRITICAL)
+            {
+#pragma omp critical(lock_bench)
+                critical_section(s, length, read);
+            }
+            else if (kind == LOCK_ATOMIC)
+            {
+                if (read)
+                {
+                    long seen;
+#pragma omp atomic read
+                    seen = s->counter.value;
+                    (void)seen;
+                }
+                else
+                {
+#pragma omp atomic
+                    s->counter.value++;
+                }
+            }
+            else
+            {
+                acquire(kind, s, &node, read);
+                t1 = split ? omp_get_wtime() : 0;
+                critical_section(s, length, read);
+                t2 = split ? omp_get_wtime() : 0;
+                release(kind, s, &node, read);
+            }
+
+            if (sampled)
+            {
+                double t3 = omp_get_wtime();
+                operations[i / LOCK_SAMPLE] = split ? NAN : t3 - t0;
+                acquired[i / LOCK_SAMPLE] = split ? t1 - t0 : NAN;
+                released[i / LOCK_SAMPLE] = split ? t3 - t2 : NAN;
+            }
+
+            work(outside);
+        }
+
+#pragma omp barrier
+#pragma omp single
+        end = omp_get_wtime();
+    }
+
+    return end - start;
+}
+
+static int compare_doubles(const void *a, const void *b)
+{
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// long append_samples() -> Appends the samples of src that are not NAN to dst[n, ...), and returns
+//  the new number of samples in dst
+long append_samples(double dst[], long n, const double src[], long count)
+{
+    for (long i = 0; i < count; i++)
+    {
+        if (!isnan(src[i]))
+        {
+            dst[n++] = src[i];
+        }
+    }
+    return n;
+}
+
+// double percentile() -> The nearest rank p-th percentile of sorted[0, n)
+double percentile(const double sorted[], long n, double p)
+{
+    long rank = (long)ceil(p / 100 * n);
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+// bool parse_lengths() -> Parses a comma separated list of critical section lengths, e.g. "0,10,100"
+bool parse_lengths(const char *arg, int lengths[], int *n_lengths)
+{
+    int n = 0;
+    const char *p = arg;
+    while (*p != '\0')
+    {
+        char *end;
+        long length = strtol(p, &end, 10);
+        if (end == p || length < 0 || n == MAX_LENGTHS)
+        {
+            return false;
+        }
+        lengths[n++] = (int)length;
+        if (*end == ',')
+        {
+            end++;
+        }
+        else if (*end != '\0')
+        {
+            return false;
+        }
+        p = end;
+    }
+
+    *n_lengths = n;
+    return n > 0;
+}
+
+int main(int argc, char *argv[])
+{
+    bench_config cfg;
+    bench_defaults(&cfg);
+    int lengths[MAX_LENGTHS] = {0, 100, 1000};
+    int n_lengths = 3;
+    int read_percent = 0;
+    int outside = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, BENCH_OPTIONS "c:R:o:")) != -1)
+    {
+        bool valid = true;
+        if (opt == 'c')
+        {
+            valid = parse_lengths(optarg, lengths, &n_lengths);
+        }
+        else if (opt == 'R')
+        {
+            read_percent = atoi(optarg);
+            valid = read_percent >= 0 && read_percent <= 100;
+        }
+        else if (opt == 'o')
+        {
+            outside = atoi(optarg);
+            valid = outside >= 0;
+        }
+        else
+        {
+            valid = bench_option(opt, optarg, &cfg);
+        }
+
+        if (!valid)
+        {
+            printf("Usage: lock_bench %s [-c critical section lengths e.g. 0,100,1000] [-R read percent] [-o work between operations] ops_per_thread \n", BENCH_USAGE);
+            return 1;
+        }
+    }
+    // Shift the arguments so the positional ones start at argv[1]
+    argc -= optind - 1;
+    argv += optind - 1;
+
+    if (argc != 2) {
+        printf("Invalid Arguments: please pass [options] ops_per_thread \n");
+        return 1;
+    }
+    bench_setup(&cfg);
+
+    long ops = atol(argv[1]);
+    long samples = ops / LOCK_SAMPLE;
+    int max_threads = 1;
+    for (int t = 0; t < cfg.n_thread_counts; t++)
+    {
+        max_threads = cfg.threads[t] > max_threads ? cfg.threads[t] : max_threads;
+    }
+
+    shared_state *s = aligned_alloc(CACHE_LINE_SIZE, sizeof(shared_state));
+    omp_init_lock(&s->omp);
+    tas_init(&s->tas);
+    ticket_init(&s->ticket);
+    mcs_init(&s->mcs);
+    rw_init(&s->rw);
+
+    double *run_samples = malloc(cfg.reps * sizeof(double));
+    double *acquire_times = malloc((max_threads * samples + 1) * sizeof(double));
+    double *release_times = malloc((max_threads * samples + 1) * sizeof(double));
+    double *operation_times = malloc((max_threads * samples + 1) * sizeof(double));
+    double *all_acquires = malloc((cfg.reps * max_threads * samples + 1) * sizeof(double));
+    double *all_releases = malloc((cfg.reps * max_threads * samples + 1) * sizeof(double));
+    double *all_operations = malloc((cfg.reps * max_threads * samples + 1) * sizeof(double));
+
+    // Open the CSV data file
+    FILE *fp;
+    fp = fopen("Data/lock_data.csv", "w"); // Open for writing, overwriting if exists
+
+    if (fp == NULL)
+    {
+        printf("Error opening file!\n");
+        exit(1); // Exit with an error code
+    }
+
+    // Write header row. Run is the time for every thread to finish its operations, Throughput
+    // the operations per second of the median run. The latencies are in nanoseconds, pooled over
+    // the sampled operations of every timed run. Operation is acquire, critical section and release
+    // together, and is the latency to compare across locks. critical and atomic cannot be split, so
+    // their Acquire and Release columns are left empty
+    fprintf(fp, "Thread Count,Reps,Lock,Critical Section,Read Percent,Outside Work,Ops Per Thread");
+    bench_write_header(fp, "Run");
+    fprintf(fp, ",Throughput,Operation P50,Operation P99,Acquire P50,Acquire P99,Release P50,Release P99");
+    bench_write_binding(fp, true);
+    fprintf(fp, "\n");
+
+    for (int c = 0; c < n_lengths; c++)
+    {
+        int length = lengths[c];
+        for (int kind = 0; kind < N_LOCKS; kind++)
+        {
+            if (kind == LOCK_ATOMIC && length > 0)
+            {
+                continue;
+            }
+
+            for (int t = 0; t < cfg.n_thread_counts; t++)
+            {
+                int n_threads = cfg.threads[t];
+                long n_operations = 0;
+                long n_splits = 0;
+
+                // Negative runs are the warm up runs and are not recorded
+                for (int rep = -cfg.warmup; rep < cfg.reps; rep++)
+                {
+                    s->counter.value = 0;
+                    double time = contend(kind, s, n_threads, ops, length, outside, read_percent, acquire_times,
+                                          release_times, operation_times);
+
+                    // Every write has to have happened exactly once
+                    long writes = 0;
+                    for (long i = 0; i < ops; i++)
+                    {
+                        writes += !is_read(i, read_percent);
+                    }
+                    assert(s->counter.value == writes * n_threads);
+
+                    if (rep >= 0)
+                    {
+                        run_samples[rep] = time;
+                        append_samples(all_acquires, n_splits, acquire_times, n_threads * samples);
+                        n_splits = append_samples(all_releases, n_splits, release_times, n_threads * samples);
+                        n_operations = append_samples(all_operations, n_operations, operation_times, n_threads * samples);
+                    }
+                }
+
+                bench_stats run = bench_summarize(run_samples, cfg.reps);
+                double throughput = n_threads * ops / run.median;
+                bool split = kind != LOCK_CRITICAL && kind != LOCK_ATOMIC;
+                double operation_p50 = 0, operation_p99 = 0;
+                double acquire_p50 = 0, acquire_p99 = 0, release_p50 = 0, release_p99 = 0;
+                if (n_operations > 0)
+                {
+                    qsort(all_operations, n_operations, sizeof(double), compare_doubles);
+                    operation_p50 = percentile(all_operations, n_operations, 50) * 1e9;
+                    operation_p99 = percentile(all_operations, n_operations, 99) * 1e9;
+                }
+                if (n_splits > 0)
+                {
+                    qsort(all_acquires, n_splits, sizeof(double), compare_doubles);
+                    qsort(all_releases, n_splits, sizeof(double), compare_doubles);
+                    acquire_p50 = percentile(all_acquires, n_splits, 50) * 1e9;
+                    acquire_p99 = percentile(all_acquires, n_splits, 99) * 1e9;
+                    release_p50 = percentile(all_releases, n_splits, 50) * 1e9;
+                    release_p99 = percentile(all_releases, n_splits, 99) * 1e9;
+                }
+                printf("%s, %d threads, critical section %d\n  Throughput: %.0lf ops/sec\n  Operation p50/p99: %.0lf/%.0lf ns\n",
+                       lock_names[kind], n_threads, length, throughput, operation_p50, operation_p99);
+
+                // Write the data to the csv file
+                fprintf(fp, "%d,%d,%s,%d,%d,%d,%ld", n_threads, cfg.reps, lock_names[kind], length, read_percent,
+                        outside, ops);
+                bench_write_stats(fp, run);
+                fprintf(fp, ",%lf,%lf,%lf", throughput, operation_p50, operation_p99);
+                if (split)
+                {
+                    fprintf(fp, ",%lf,%lf,%lf,%lf", acquire_p50, acquire_p99, release_p50, release_p99);
+                }
+                else
+                {
+                    fprintf(fp, ",,,,");
+                }
+                bench_write_binding(fp, false);
+                fprintf(fp, "\n");
+            }
+        }
+    }
+
+    fclose(fp); // Close the file
+    printf("Data written to lock_data.csv successfully\n");
+
+    omp_destroy_lock(&s->omp);
+    free(s);
+    free(run_samples);
+    free(acquire_times);
+    free(release_times);
+    free(operation_times);
+    free(all_acquires);
+    free(all_releases);
+    free(all_operations);
+
+    return 0;
+}
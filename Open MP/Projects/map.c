@@ -4,14 +4,26 @@
 #include <time.h>
 #include <string.h>
 #include <assert.h>
+#include <stdbool.h>
+#include <unistd.h>
+
+#include "bench.h"
+#include "buffer.h"
+#include "memo.h"
+#include "profile.h"
+#include "schedule.h"
+#include "simd_map.h"
+#include "steal.h"
 
 // map_function() -> This function takes in an integer and either returns its square if
 //  the number is even or its cube if the number is odd
 // INPUTS
 //  - int x -> The number that will be operated on
+//
+// The counter is volatile so the compiler keeps the loop and the cost stays proportional to x
 int map_function(int x)
 {
-    int sum = 0;
+    volatile int sum = 0;
     for (int i = 0; i < x; i++)
     {
         sum += 1;
@@ -20,6 +32,15 @@ int map_function(int x)
     return sum;
 }
 
+// The memo the memoized runs look map_function() results up in
+static memo map_memo;
+
+// int memoized_map_function() -> map_function(x), looked up in map_memo
+int memoized_map_function(int x)
+{
+    return memo_get(&map_memo, x);
+}
+
 // serial_map() -> This function maps a list of variables into one using a given operation function
 // INPUTS
 //  - int (*operator_func)(int x) -> This is a pointer to a function that takes in an integer and returns an int
@@ -42,7 +63,26 @@ void serial_map(int (*operator_func)(int x), int vals[], int len, double *serial
     printf("Serial\n   Time: %lf\n", time_diff);
 }
 
-// parallel_map() -> This function reduces a list of integer values into one using parallel loops
+// map_range -> What map_range_body() needs to map one range of the array
+typedef struct
+{
+    int (*operator_func)(int x);
+    int *vals;
+} map_range;
+
+// void map_range_body() -> Maps vals[begin, end) in place, used by the work stealing runtime
+void map_range_body(long begin, long end, void *ctx)
+{
+    map_range *range = ctx;
+    for (long i = begin; i < end; i++)
+    {
+        range->vals[i] = range->operator_func(range->vals[i]);
+    }
+}
+
+// parallel_map() -> This function reduces a list of integer values into one using parallel loops.
+//  The loop uses the schedule set with schedule_apply(), or the work stealing runtime if that
+//  schedule is "steal"
 // INPUTS
 //  - char operator -> The operator the should be used for the reduction
 //  - int vals[] -> This is a lit of integer values that will be reduced using the operator function
@@ -50,11 +90,30 @@ void serial_map(int (*operator_func)(int x), int vals[], int len, double *serial
 void parallel_map(int (*operator_func)(int x), int vals[], int len, int n_threads, double *parallel_time)
 {
     double start = omp_get_wtime();
-#pragma omp parallel for num_threads(n_threads)
-    for (int i = 0; i < len; i++)
+    const schedule_policy *policy = schedule_current();
+    if (policy->steal)
     {
-        int val = operator_func(vals[i]);
-        vals[i] = val;
+        map_range range = {operator_func, vals};
+        steal_for(len, policy->chunk, map_range_body, &range, n_threads);
+    }
+    else
+    {
+        profile_region_begin("map");
+#pragma omp parallel num_threads(n_threads)
+        {
+            profile_thread_begin();
+            profile_chunks chunks = PROFILE_CHUNKS_INIT;
+#pragma omp for schedule(runtime) nowait
+            for (int i = 0; i < len; i++)
+            {
+                profile_chunk_next(&chunks, i);
+                int val = operator_func(vals[i]);
+                vals[i] = val;
+            }
+            profile_chunk_done(&chunks);
+            profile_thread_end();
+        }
+        profile_region_end();
     }
     double end = omp_get_wtime();
     double time_diff = end - start;
@@ -64,22 +123,125 @@ void parallel_map(int (*operator_func)(int x), int vals[], int len, int n_thread
     printf("Parallel\n   Time: %lf\n", time_diff);
 }
 
+// void specialized_map() -> Maps vals in place with the compile time specialized kernel for op on
+//  the widest instruction set the CPU supports, chosen at runtime. Every thread maps one contiguous
+//  block, so the schedule set with schedule_apply() does not apply
+// INPUTS
+//  - map_op op -> The operator to apply
+//  - int vals[] -> The values to map
+//  - int len -> The length of the value array
+void specialized_map(map_op op, int vals[], int len, int n_threads, double *parallel_time)
+{
+    double start = omp_get_wtime();
+    simd_map(op, map_isa_best(), vals, len, n_threads);
+    double time_diff = omp_get_wtime() - start;
+
+    *parallel_time = time_diff;
+
+    printf("Parallel (%s)\n   Time: %lf\n", map_isa_name(map_isa_best()), time_diff);
+}
+
+// map_trial -> The sample the schedule auto tuner runs parallel_map() on
+typedef struct
+{
+    int (*operator_func)(int x);
+    const int *sample;
+    int *work;
+    int len;
+    int n_threads;
+} map_trial;
+
+// double time_map_trial() -> Runs parallel_map() once on a fresh copy of the sample
+double time_map_trial(void *ctx)
+{
+    map_trial *trial = ctx;
+    double time;
+
+    memcpy(trial->work, trial->sample, (size_t)trial->len * sizeof(int));
+    parallel_map(trial->operator_func, trial->work, trial->len, trial->n_threads, &time);
+    return time;
+}
+
 int main(int argc, char *argv[])
 {
-    if (argc != 3) {
-        printf("Invalid Arguments: please pass length and MAX_VAL \n");
+    // -s picks the parallel loop schedule, e.g. -s dynamic,64 or -s auto.
+    // -M picks how map_function() results are memoized (off, table, cache or auto).
+    // -o maps with one of the simd_map.h operators (count, square, affine or abs) instead of
+    // map_function(), running its specialized kernel for the best instruction set the CPU has.
+    // The other options configure the benchmark harness (see bench.h)
+    schedule_policy policy = {omp_sched_static, 0, false};
+    bool tune = false;
+    memo_mode memo_setting = MEMO_AUTO;
+    int op = -1;
+    bench_config cfg;
+    bench_defaults(&cfg);
+    int opt;
+    while ((opt = getopt(argc, argv, "s:M:o:" BENCH_OPTIONS)) != -1)
+    {
+        bool ok;
+        if (opt == 's')
+        {
+            ok = schedule_option(optarg, &policy, &tune);
+        }
+        else if (opt == 'M')
+        {
+            ok = memo_parse(optarg, &memo_setting);
+        }
+        else if (opt == 'o')
+        {
+            op = map_op_find(optarg);
+            ok = op >= 0;
+        }
+        else
+        {
+            ok = bench_option(opt, optarg, &cfg);
+        }
+        if (!ok)
+        {
+            printf("Invalid Arguments: -s takes static, dynamic, guided or steal (with an optional ,chunk) or auto, -M takes off, table, cache or auto, -o takes count, square, affine or abs \n");
+            printf("Usage: map [-s schedule] [-M memo] [-o operator] %s length MAX_VAL [input file] \n", BENCH_USAGE);
+            return 1;
+        }
+    }
+    // Shift the arguments so the positional ones start at argv[1]
+    argc -= optind - 1;
+    argv += optind - 1;
+
+    if (argc != 3 && argc != 4) {
+        printf("Invalid Arguments: please pass [options] length and MAX_VAL (and optionally a binary input file) \n");
         return 1;
     }
+    bench_setup(&cfg);
+
+    // The serial and pointer based runs call the operator through a function pointer, the
+    // specialized runs inline it
+    int (*operator_func)(int x) = op >= 0 ? map_op_func(op) : map_function;
+
     // Instantiate the basic variables for the reduction step
     // These will be taken from the command line
     int len = atoi(argv[1]);
     int MAX_VAL = atoi(argv[2]);
 
-    int vals[len];
-    for (int i = 0; i < len; i++)
+    // The input either comes from a memory mapped binary file or is generated on the heap
+    int_buffer vals;
+    if (argc == 4)
+    {
+        if (!buffer_map_file(argv[3], &vals))
+        {
+            printf("Error mapping input file %s!\n", argv[3]);
+            exit(1);
+        }
+        // A length of 0 (or one longer than the file) means use the whole file
+        if (len > 0 && (size_t)len < vals.len)
+        {
+            vals.len = len;
+        }
+        len = vals.len;
+    }
+    else
     {
-        int random_val = (rand() % MAX_VAL) + 1;
-        vals[i] = random_val;
+        vals = buffer_alloc(len, omp_get_max_threads());
+        bench_fill(&cfg, vals.data, len, MAX_VAL);
     }
 
     // Open the CSV data file
@@ -92,40 +254,114 @@ int main(int argc, char *argv[])
         exit(1); // Exit with an error code
     }
 
-    // Write header row
-    fprintf(fp, "Thread Count,Trial,Serial Time,Parallel Time, Array Size\n");
+    // Write header row. Every row summarizes the timed runs at one thread count
+    fprintf(fp, "Thread Count,Reps,Array Size");
+    bench_write_header(fp, "Serial");
+    bench_write_header(fp, "Parallel");
+    fprintf(fp, ",Speedup,Copy Time,Schedule,Chunk Size,Memo,Memo Hit Rate,Operator,ISA");
+    bench_write_binding(fp, true);
+    fprintf(fp, "\n");
 
-    for (int n_threads = 1; n_threads < 9; n_threads++)
+    // The working copies are allocated once and refilled every run
+    int_buffer serial_vals = buffer_alloc(len, 1);
+    int_buffer parallel_vals = buffer_alloc(len, omp_get_max_threads());
+    double *serial_samples = malloc(cfg.reps * sizeof(double));
+    double *parallel_samples = malloc(cfg.reps * sizeof(double));
+    double *copy_samples = malloc(cfg.reps * sizeof(double));
+
+    // The serial baseline does not depend on the thread count, so it is timed once.
+    // Negative runs are the warm up runs and are not recorded
+    for (int rep = -cfg.warmup; rep < cfg.reps; rep++)
     {
-        for (int trial = 1; trial < 4; trial++)
+        double serial_time;
+        buffer_copy(&serial_vals, &vals, omp_get_max_threads());
+        serial_map(operator_func, serial_vals.data, len, &serial_time);
+        if (rep >= 0)
         {
-            // Create a list of random integer variables of length len with max value MAX_VAL
-            int serial_vals[len];
-            int parallel_vals[len];
+            serial_samples[rep] = serial_time;
+        }
+    }
+    bench_stats serial = bench_summarize(serial_samples, cfg.reps);
 
-            memcpy(serial_vals, vals, len * sizeof(int));
-            memcpy(parallel_vals, vals, len * sizeof(int));
+    schedule_apply(&policy);
+    for (int t = 0; t < cfg.n_thread_counts; t++)
+    {
+        int n_threads = cfg.threads[t];
 
-            double parallel_time;
-            double serial_time;
+        // The best schedule depends on the thread count, so tune for every one
+        if (tune)
+        {
+            map_trial sample = {operator_func, vals.data, parallel_vals.data, len < SCHEDULE_SAMPLE_LEN ? len : SCHEDULE_SAMPLE_LEN, n_threads};
+            policy = schedule_autotune(time_map_trial, &sample);
+        }
+
+        // Decide once per thread count whether memoizing pays. Auto stays off when a call is
+        // cheaper than a lookup, so the plain parallel map runs
+        memo_mode mode = memo_setting == MEMO_AUTO ? memo_choose(operator_func, vals.data, len, n_threads) : memo_setting;
+        double hit_rate = 0;
 
-            // Calculate parallel result
-            parallel_map(map_function, parallel_vals, len, n_threads, &parallel_time);
+        for (int rep = -cfg.warmup; rep < cfg.reps; rep++)
+        {
+            // Copy the input into the working buffer and record what that costs
+            double copy_time = buffer_copy(&parallel_vals, &vals, n_threads);
 
-            // Calculate the serial result
-            serial_map(map_function, serial_vals, len, &serial_time);
+            // Calculate parallel result. A memoized run includes building the memo
+            double parallel_time;
+            if (mode == MEMO_OFF && op >= 0)
+            {
+                specialized_map(op, parallel_vals.data, len, n_threads, &parallel_time);
+            }
+            else if (mode == MEMO_OFF)
+            {
+                parallel_map(map_function, parallel_vals.data, len, n_threads, &parallel_time);
+            }
+            else
+            {
+                double build_start = omp_get_wtime();
+                memo_create(&map_memo, mode, operator_func, parallel_vals.data, len, n_threads);
+                double build_time = omp_get_wtime() - build_start;
+                parallel_map(memoized_map_function, parallel_vals.data, len, n_threads, &parallel_time);
+                parallel_time += build_time;
+                hit_rate = memo_hit_rate(&map_memo, len);
+                memo_free(&map_memo);
+            }
 
             // Check that the two results are the same
-            assert(memcmp(parallel_vals, serial_vals, len * sizeof(int)) == 0);
-            printf("Assertion 1 passed: The two results are the same\n");
+            assert(memcmp(parallel_vals.data, serial_vals.data, (size_t)len * sizeof(int)) == 0);
 
-            // Write the data to the csv file
-            fprintf(fp, "%d,%d,%lf,%lf,%d\n", n_threads, trial, serial_time, parallel_time, len);
+            if (rep >= 0)
+            {
+                parallel_samples[rep] = parallel_time;
+                copy_samples[rep] = copy_time;
+            }
         }
+        printf("Assertion 1 passed: The two results are the same\n");
+
+        bench_stats parallel = bench_summarize(parallel_samples, cfg.reps);
+        bench_stats copy = bench_summarize(copy_samples, cfg.reps);
+        printf("%d threads\n  Serial median: %lf\n  Parallel median: %lf (p95 %lf)\n", n_threads, serial.median, parallel.median, parallel.p95);
+
+        // Write the data to the csv file
+        fprintf(fp, "%d,%d,%d", n_threads, cfg.reps, len);
+        bench_write_stats(fp, serial);
+        bench_write_stats(fp, parallel);
+        fprintf(fp, ",%lf,%lf,%s,%d,%s,%lf", serial.median / parallel.median, copy.median, schedule_name(&policy), policy.chunk, memo_name(mode), hit_rate);
+        fprintf(fp, ",%s,%s", op >= 0 ? map_op_name(op) : "map_function",
+                op >= 0 && mode == MEMO_OFF ? map_isa_name(map_isa_best()) : "scalar");
+        bench_write_binding(fp, false);
+        fprintf(fp, "\n");
     }
 
     fclose(fp); // Close the file
-    printf("Data written to people.csv successfully\n");
+    printf("Data written to map_data.csv successfully\n");
+    profile_write_report("Data/profile_data");
+
+    free(serial_samples);
+    free(parallel_samples);
+    free(copy_samples);
+    buffer_free(&serial_vals);
+    buffer_free(&parallel_vals);
+    buffer_free(&vals);
 
     return 0;
-}
\ No newline at end of file
+}
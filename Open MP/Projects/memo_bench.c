@@ -0,0 +1,239 @@
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <assert.h>
+#include <unistd.h>
+
+#include "bench.h"
+#include "buffer.h"
+#include "memo.h"
+#include "rng.h"
+
+// The most domain sizes one run can sweep over
+#define MAX_DOMAINS 16
+
+// How many xorshift rounds expensive_function() runs on top of the value dependent ones
+static int work_rounds;
+
+// int expensive_function() -> A pure function whose cost grows with x (up to 255 extra rounds),
+//  like map_function(), but with a result that is not just a count
+//
+// INPUTS
+//  - int x -> The number that will be operated on
+int expensive_function(int x)
+{
+    uint32_t h = (uint32_t)x | 1;
+    int rounds = work_rounds + (x & 255);
+    for (int i = 0; i < rounds; i++)
+    {
+        h ^= h << 13;
+        h ^= h >> 17;
+        h ^= h << 5;
+    }
+    return (int)(h & 0x7fffffff);
+}
+
+// bool parse_domains() -> Parses a comma separated list of domain sizes, e.g. "1000,100000"
+bool parse_domains(const char *arg, int domains[], int *n_domains)
+{
+    int n = 0;
+    const char *p = arg;
+    while (*p != '\0')
+    {
+        char *end;
+        long domain = strtol(p, &end, 10);
+        if (end == p || domain < 1 || domain > 1 << 30 || n == MAX_DOMAINS)
+        {
+            return false;
+        }
+        domains[n++] = (int)domain;
+        if (*end == ',')
+        {
+            end++;
+        }
+        else if (*end != '\0')
+        {
+            return false;
+        }
+        p = end;
+    }
+
+    *n_domains = n;
+    return n > 0;
+}
+
+// double time_memo_map() -> Builds a memo and maps the input through it, checking the output
+//  against the expected one. Returns the time of both together
+//
+// INPUTS
+//  - memo_mode mode -> How to memoize
+//  - const int in[] -> The input values
+//  - int out[] -> Where the mapped values go
+//  - const int expected[] -> The serially mapped values
+//  - long len -> The length of the arrays
+//  - int n_threads -> The number of threads to use
+//  - memo_mode* used -> Set to the mode the memo ended up with
+//  - double* hit_rate -> Set to the fraction of lookups that did not call the function
+double time_memo_map(memo_mode mode, const int in[], int out[], const int expected[], long len, int n_threads,
+                     memo_mode *used, double *hit_rate)
+{
+    memo m;
+    double start = omp_get_wtime();
+    memo_create(&m, mode, expensive_function, in, len, n_threads);
+    memo_map(&m, in, out, len, n_threads);
+    double time = omp_get_wtime() - start;
+
+    assert(memcmp(out, expected, (size_t)len * sizeof(int)) == 0);
+    *used = m.mode;
+    *hit_rate = memo_hit_rate(&m, len);
+    memo_free(&m);
+    return time;
+}
+
+int main(int argc, char *argv[])
+{
+    bench_config cfg;
+    bench_defaults(&cfg);
+    int domains[MAX_DOMAINS] = {1000, 100000, 10000000};
+    int n_domains = 3;
+    int opt;
+    while ((opt = getopt(argc, argv, BENCH_OPTIONS "d:")) != -1)
+    {
+        if (opt == 'd' ? !parse_domains(optarg, domains, &n_domains) : !bench_option(opt, optarg, &cfg))
+        {
+            printf("Usage: memo_bench %s [-d domain sizes e.g. 1000,100000] length work \n", BENCH_USAGE);
+            return 1;
+        }
+    }
+    // Shift the arguments so the positional ones start at argv[1]
+    argc -= optind - 1;
+    argv += optind - 1;
+
+    if (argc != 3) {
+        printf("Invalid Arguments: please pass [options] length and the xorshift rounds every call costs \n");
+        return 1;
+    }
+    bench_setup(&cfg);
+
+    long len = atol(argv[1]);
+    work_rounds = atoi(argv[2]);
+
+    int_buffer vals = buffer_alloc(len, omp_get_max_threads());
+    int_buffer expected = buffer_alloc(len, omp_get_max_threads());
+    int_buffer out = buffer_alloc(len, omp_get_max_threads());
+    double *samples[5];
+    for (int s = 0; s < 5; s++)
+    {
+        samples[s] = malloc(cfg.reps * sizeof(double));
+    }
+
+    // Open the CSV data file
+    FILE *fp;
+    fp = fopen("Data/memo_data.csv", "w"); // Open for writing, overwriting if exists
+
+    if (fp == NULL)
+    {
+        printf("Error opening file!\n");
+        exit(1); // Exit with an error code
+    }
+
+    // Write header row. Parallel maps without memoizing, Table and Cache force one kind of memo
+    // and Auto is whatever memo_choose() picks (Auto Mode). Every memoized time includes building
+    // the memo. Table is left at 0 for domains wider than MEMO_TABLE_MAX
+    fprintf(fp, "Thread Count,Reps,Array Size,Domain,Work,Key Distribution,Auto Mode");
+    bench_write_header(fp, "Serial");
+    bench_write_header(fp, "Parallel");
+    bench_write_header(fp, "Table");
+    bench_write_header(fp, "Cache");
+    bench_write_header(fp, "Auto");
+    fprintf(fp, ",Table Hit Rate,Cache Hit Rate,Auto Hit Rate,Speedup,Memo Speedup");
+    bench_write_binding(fp, true);
+    fprintf(fp, "\n");
+
+    for (int d = 0; d < n_domains; d++)
+    {
+        int domain = domains[d];
+        rng_fill(&cfg.dist, cfg.seed, vals.data, len, domain, omp_get_max_threads());
+
+        // The serial baseline does not depend on the thread count, so it is timed once.
+        // Negative runs are the warm up runs and are not recorded
+        for (int rep = -cfg.warmup; rep < cfg.reps; rep++)
+        {
+            double start = omp_get_wtime();
+            for (long i = 0; i < len; i++)
+            {
+                expected.data[i] = expensive_function(vals.data[i]);
+            }
+            double serial_time = omp_get_wtime() - start;
+            if (rep >= 0)
+            {
+                samples[0][rep] = serial_time;
+            }
+        }
+        bench_stats serial = bench_summarize(samples[0], cfg.reps);
+
+        for (int t = 0; t < cfg.n_thread_counts; t++)
+        {
+            int n_threads = cfg.threads[t];
+            memo_mode modes[4] = {MEMO_OFF, MEMO_TABLE, MEMO_CACHE, MEMO_AUTO};
+            memo_mode used[4] = {MEMO_OFF, MEMO_TABLE, MEMO_CACHE, MEMO_OFF};
+            double hit_rates[4] = {0, 0, 0, 0};
+            // The values are in [1, domain], so that is the range a table would cover
+            bool table_fits = domain <= MEMO_TABLE_MAX;
+
+            for (int rep = -cfg.warmup; rep < cfg.reps; rep++)
+            {
+                for (int s = 0; s < 4; s++)
+                {
+                    double time = 0;
+                    if (modes[s] != MEMO_TABLE || table_fits)
+                    {
+                        time = time_memo_map(modes[s], vals.data, out.data, expected.data, len, n_threads,
+                                             &used[s], &hit_rates[s]);
+                    }
+                    if (rep >= 0)
+                    {
+                        samples[s + 1][rep] = time;
+                    }
+                }
+            }
+            printf("Assertion 1 passed: Every memoized result is the same as the serial one\n");
+
+            bench_stats parallel = bench_summarize(samples[1], cfg.reps);
+            bench_stats table = bench_summarize(samples[2], cfg.reps);
+            bench_stats cache = bench_summarize(samples[3], cfg.reps);
+            bench_stats automatic = bench_summarize(samples[4], cfg.reps);
+            printf("Domain %d, %d threads\n  Serial median: %lf\n  Parallel median: %lf\n  Table median: %lf (hit rate %lf)\n  Cache median: %lf (hit rate %lf)\n  Auto median: %lf (picks %s)\n",
+                   domain, n_threads, serial.median, parallel.median, table.median, hit_rates[1], cache.median,
+                   hit_rates[2], automatic.median, memo_name(used[3]));
+
+            // Write the data to the csv file
+            fprintf(fp, "%d,%d,%ld,%d,%d,%s,%s", n_threads, cfg.reps, len, domain, work_rounds, rng_name(&cfg.dist),
+                    memo_name(used[3]));
+            bench_write_stats(fp, serial);
+            bench_write_stats(fp, parallel);
+            bench_write_stats(fp, table);
+            bench_write_stats(fp, cache);
+            bench_write_stats(fp, automatic);
+            fprintf(fp, ",%lf,%lf,%lf,%lf,%lf", hit_rates[1], hit_rates[2], hit_rates[3], serial.median / automatic.median,
+                    parallel.median / automatic.median);
+            bench_write_binding(fp, false);
+            fprintf(fp, "\n");
+        }
+    }
+
+    fclose(fp); // Close the file
+    printf("Data written to memo_data.csv successfully\n");
+
+    for (int s = 0; s < 5; s++)
+    {
+        free(samples[s]);
+    }
+    buffer_free(&vals);
+    buffer_free(&expected);
+    buffer_free(&out);
+
+    return 0;
+}
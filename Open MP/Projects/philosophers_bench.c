@@ -0,0 +1,343 @@
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+#include "arbiter.h"
+#include "bench.h"
+
+// How the philosophers get their chopsticks
+//  - SPIN -> dining_philosophers.c: a counting semaphore of n - 1 seats spun on under an omp_lock,
+//      then omp_lock chopsticks taken left then right
+//  - CRITICAL -> dp2.c: both chopsticks checked and taken inside one global critical section,
+//      sleeping a random back off and trying again when either is taken
+//  - ORDERED -> Futex chopsticks taken lowest numbered first, no semaphore (see arbiter.h)
+//  - SEMAPHORE -> A futex counting semaphore of n - 1 seats, then futex chopsticks taken left
+//      then right
+typedef enum
+{
+    STRATEGY_SPIN,
+    STRATEGY_CRITICAL,
+    STRATEGY_ORDERED,
+    STRATEGY_SEMAPHORE,
+    N_STRATEGIES
+} strategy;
+
+static const char *strategy_names[N_STRATEGIES] = {"spin", "critical", "ordered", "semaphore"};
+
+// table -> The shared state of every strategy, only the parts the running strategy uses are touched
+typedef struct
+{
+    int n_seats;
+    omp_lock_t *locks;
+    omp_lock_t sem_lock;
+    int sem_count;
+    int *available;
+    chopstick *sticks;
+    semaphore seats;
+    int backoff_us;
+} table;
+
+// void work() -> Eating or thinking: takes time proportional to units. The counter is volatile so
+//  the compiler cannot fold the loop into a single add
+void work(int units)
+{
+    volatile int sum = 0;
+    for (int i = 0; i < units; i++)
+    {
+        sum += 1;
+    }
+}
+
+// void pick_up() -> Blocks until the philosopher at seat holds both chopsticks
+//
+// INPUTS
+//  - strategy s -> How the chopsticks are taken
+//  - table* t -> The table
+//  - int seat -> The philosopher's seat
+//  - unsigned int* seed -> The philosopher's rand_r() state, for the critical back off
+void pick_up(strategy s, table *t, int seat, unsigned int *seed)
+{
+    int left = seat;
+    int right = (seat + 1) % t->n_seats;
+
+    switch (s)
+    {
+    case STRATEGY_SPIN:
+        // Spin until a seat is free, as acquire_semaphore() in dining_philosophers.c does
+        while (1)
+        {
+            omp_set_lock(&t->sem_lock);
+            if (t->sem_count > 0)
+            {
+                t->sem_count--;
+                omp_unset_lock(&t->sem_lock);
+                break;
+            }
+            omp_unset_lock(&t->sem_lock);
+        }
+        omp_set_lock(&t->locks[left]);
+        omp_set_lock(&t->locks[right]);
+        break;
+    case STRATEGY_CRITICAL:
+        while (1)
+        {
+            int taken = 0;
+#pragma omp critical(philosophers)
+            {
+                if (t->available[left] && t->available[right])
+                {
+                    t->available[left] = 0;
+                    t->available[right] = 0;
+                    taken = 1;
+                }
+            }
+            if (taken)
+            {
+                break;
+            }
+            usleep(t->backoff_us + rand_r(seed) % (t->backoff_us + 1));
+        }
+        break;
+    case STRATEGY_ORDERED:
+        table_pick_up(t->sticks, t->n_seats, seat);
+        break;
+    default:
+        semaphore_wait(&t->seats);
+        chopstick_pick_up(&t->sticks[left]);
+        chopstick_pick_up(&t->sticks[right]);
+        break;
+    }
+}
+
+// void put_down() -> Returns both chopsticks of the philosopher at seat
+void put_down(strategy s, table *t, int seat)
+{
+    int left = seat;
+    int right = (seat + 1) % t->n_seats;
+
+    switch (s)
+    {
+    case STRATEGY_SPIN:
+        omp_unset_lock(&t->locks[left]);
+        omp_unset_lock(&t->locks[right]);
+        // dining_philosophers.c increments with omp atomic, which does not exclude the decrement
+        // done under sem_lock in pick_up(), so an update could be lost. Take the lock here too
+        omp_set_lock(&t->sem_lock);
+        t->sem_count++;
+        omp_unset_lock(&t->sem_lock);
+        break;
+    case STRATEGY_CRITICAL:
+#pragma omp critical(philosophers)
+        {
+            t->available[left] = 1;
+            t->available[right] = 1;
+        }
+        break;
+    case STRATEGY_ORDERED:
+        table_put_down(t->sticks, t->n_seats, seat);
+        break;
+    default:
+        chopstick_put_down(&t->sticks[left]);
+        chopstick_put_down(&t->sticks[right]);
+        semaphore_post(&t->seats);
+        break;
+    }
+}
+
+// void dine() -> Has n_seats philosophers think, pick up, eat and put down until the time is up
+//
+// INPUTS
+//  - strategy s -> How the chopsticks are taken
+//  - table* t -> The table, with every chopstick free
+//  - double seconds -> How long the dinner lasts
+//  - int eat_work -> The work units of one meal, done holding both chopsticks
+//  - int think_work -> The work units between meals
+//  - long meals[] -> Set to the number of meals each philosopher ate
+void dine(strategy s, table *t, double seconds, int eat_work, int think_work, long meals[])
+{
+#pragma omp parallel num_threads(t->n_seats)
+    {
+        int seat = omp_get_thread_num();
+        unsigned int seed = (unsigned int)seat + 1;
+        long eaten = 0;
+
+#pragma omp barrier
+        double deadline = omp_get_wtime() + seconds;
+        while (omp_get_wtime() < deadline)
+        {
+            work(think_work);
+            pick_up(s, t, seat, &seed);
+            work(eat_work);
+            put_down(s, t, seat);
+            eaten++;
+        }
+        meals[seat] = eaten;
+    }
+}
+
+// double cpu_seconds() -> User plus system time the process has used so far. Spinning strategies
+//  burn it while waiting, blocking ones do not
+double cpu_seconds()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 + usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+}
+
+int main(int argc, char *argv[])
+{
+    bench_config cfg;
+    bench_defaults(&cfg);
+    int backoff_us = 100;
+    int opt;
+    while ((opt = getopt(argc, argv, BENCH_OPTIONS "s:")) != -1)
+    {
+        if (opt == 's')
+        {
+            backoff_us = atoi(optarg);
+        }
+        else if (!bench_option(opt, optarg, &cfg))
+        {
+            printf("Usage: philosophers_bench %s [-s critical back off in microseconds] seconds eat_work think_work \n", BENCH_USAGE);
+            return 1;
+        }
+    }
+    // Shift the arguments so the positional ones start at argv[1]
+    argc -= optind - 1;
+    argv += optind - 1;
+
+    if (argc != 4 || backoff_us < 1) {
+        printf("Invalid Arguments: please pass [options] seconds eat_work and think_work \n");
+        return 1;
+    }
+    bench_setup(&cfg);
+
+    double seconds = atof(argv[1]);
+    int eat_work = atoi(argv[2]);
+    int think_work = atoi(argv[3]);
+
+    double *rate_samples = malloc(cfg.reps * sizeof(double));
+    double *spread_samples = malloc(cfg.reps * sizeof(double));
+    double *jain_samples = malloc(cfg.reps * sizeof(double));
+    double *cpu_samples = malloc(cfg.reps * sizeof(double));
+
+    // Open the CSV data file
+    FILE *fp;
+    fp = fopen("Data/philosophers_data.csv", "w"); // Open for writing, overwriting if exists
+
+    if (fp == NULL)
+    {
+        printf("Error opening file!\n");
+        exit(1); // Exit with an error code
+    }
+
+    // Write header row. Spread is (most meals - fewest meals) / mean meals and the Jain index is
+    // (sum of meals)^2 / (n * sum of meals^2), 1 when every philosopher ate the same amount.
+    // CPU Per Meal is the process CPU time divided by the meals eaten
+    fprintf(fp, "Thread Count,Reps,Strategy,Seconds,Eat Work,Think Work,Back Off,Meals Per Sec,Meals Per Sec P95,Meals Per Sec Stddev,Spread,Jain Index,CPU Per Meal");
+    bench_write_binding(fp, true);
+    fprintf(fp, "\n");
+
+    for (int t = 0; t < cfg.n_thread_counts; t++)
+    {
+        int n_seats = cfg.threads[t];
+        // One philosopher has a single chopstick for both hands, and a semaphore of n - 1 seats
+        // would never let them sit down
+        if (n_seats < 2)
+        {
+            printf("Skipping %d thread(s): the table needs at least 2 philosophers\n", n_seats);
+            continue;
+        }
+
+        table tab;
+        tab.n_seats = n_seats;
+        tab.backoff_us = backoff_us;
+        tab.locks = malloc(n_seats * sizeof(omp_lock_t));
+        tab.available = malloc(n_seats * sizeof(int));
+        tab.sticks = aligned_alloc(CACHE_LINE_SIZE, n_seats * sizeof(chopstick));
+        long *meals = malloc(n_seats * sizeof(long));
+        omp_init_lock(&tab.sem_lock);
+        for (int i = 0; i < n_seats; i++)
+        {
+            omp_init_lock(&tab.locks[i]);
+            chopstick_init(&tab.sticks[i]);
+        }
+
+        for (int s = 0; s < N_STRATEGIES; s++)
+        {
+            // Negative runs are the warm up runs and are not recorded
+            for (int rep = -cfg.warmup; rep < cfg.reps; rep++)
+            {
+                tab.sem_count = n_seats - 1;
+                semaphore_init(&tab.seats, n_seats - 1);
+                for (int i = 0; i < n_seats; i++)
+                {
+                    tab.available[i] = 1;
+                }
+
+                double cpu_start = cpu_seconds();
+                double start = omp_get_wtime();
+                dine(s, &tab, seconds, eat_work, think_work, meals);
+                double time = omp_get_wtime() - start;
+                double cpu = cpu_seconds() - cpu_start;
+
+                long total = 0;
+                long fewest = meals[0];
+                long most = meals[0];
+                double squares = 0;
+                for (int i = 0; i < n_seats; i++)
+                {
+                    total += meals[i];
+                    fewest = meals[i] < fewest ? meals[i] : fewest;
+                    most = meals[i] > most ? meals[i] : most;
+                    squares += (double)meals[i] * meals[i];
+                }
+                double mean = (double)total / n_seats;
+
+                if (rep >= 0)
+                {
+                    rate_samples[rep] = total / time;
+                    spread_samples[rep] = total > 0 ? (most - fewest) / mean : 0;
+                    jain_samples[rep] = squares > 0 ? (double)total * total / (n_seats * squares) : 0;
+                    cpu_samples[rep] = total > 0 ? cpu / total : 0;
+                }
+            }
+
+            bench_stats rate = bench_summarize(rate_samples, cfg.reps);
+            double spread = bench_summarize(spread_samples, cfg.reps).median;
+            double jain = bench_summarize(jain_samples, cfg.reps).median;
+            double cpu_per_meal = bench_summarize(cpu_samples, cfg.reps).median;
+            printf("%s, %d philosophers\n  Meals/sec median: %.0lf\n  Spread: %.3lf (Jain %.3lf)\n  CPU per meal: %.3le s\n",
+                   strategy_names[s], n_seats, rate.median, spread, jain, cpu_per_meal);
+
+            // Write the data to the csv file
+            fprintf(fp, "%d,%d,%s,%lf,%d,%d,%d,%lf,%lf,%lf,%lf,%lf,%le", n_seats, cfg.reps, strategy_names[s], seconds,
+                    eat_work, think_work, backoff_us, rate.median, rate.p95, rate.stddev, spread, jain, cpu_per_meal);
+            bench_write_binding(fp, false);
+            fprintf(fp, "\n");
+        }
+
+        for (int i = 0; i < n_seats; i++)
+        {
+            omp_destroy_lock(&tab.locks[i]);
+        }
+        omp_destroy_lock(&tab.sem_lock);
+        free(tab.locks);
+        free(tab.available);
+        free(tab.sticks);
+        free(meals);
+    }
+
+    fclose(fp); // Close the file
+    printf("Data written to philosophers_data.csv successfully\n");
+
+    free(rate_samples);
+    free(spread_samples);
+    free(jain_samples);
+    free(cpu_samples);
+
+    return 0;
+}
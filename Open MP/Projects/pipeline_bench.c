@@ -0,0 +1,122 @@
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <unistd.h>
+
+#include "bench.h"
+#include "buffer.h"
+#include "pipeline.h"
+#include "schedule.h"
+
+int main(int argc, char *argv[])
+{
+    bench_config cfg;
+    bench_defaults(&cfg);
+    int opt;
+    while ((opt = getopt(argc, argv, BENCH_OPTIONS)) != -1)
+    {
+        if (!bench_option(opt, optarg, &cfg))
+        {
+            printf("Usage: pipeline_bench %s length MAX_VAL [pipeline] \n", BENCH_USAGE);
+            return 1;
+        }
+    }
+    // Shift the arguments so the positional ones start at argv[1]
+    argc -= optind - 1;
+    argv += optind - 1;
+
+    if (argc != 3 && argc != 4) {
+        printf("Invalid Arguments: please pass [options] length and MAX_VAL (and optionally a pipeline such as map:affine,filter:even,reduce:add) \n");
+        return 1;
+    }
+    bench_setup(&cfg);
+
+    int len = atoi(argv[1]);
+    int MAX_VAL = atoi(argv[2]);
+    const char *spec = argc == 4 ? argv[3] : "map:affine,filter:even,reduce:add";
+
+    pipeline p;
+    if (!pipeline_parse(spec, &p) || p.reduce == NULL)
+    {
+        printf("Invalid Arguments: %s is not a pipeline. Stages are map:count|square|affine|abs, filter:even|odd|positive and a final reduce:add|mult|max|min|gcd \n", spec);
+        return 1;
+    }
+
+    // The staged run ends in reduce_run(), which follows the runtime schedule
+    schedule_policy policy = {omp_sched_static, 0, false};
+    schedule_apply(&policy);
+
+    int_buffer vals = buffer_alloc(len, omp_get_max_threads());
+    bench_fill(&cfg, vals.data, len, MAX_VAL);
+    double *staged_samples = malloc(cfg.reps * sizeof(double));
+    double *fused_samples = malloc(cfg.reps * sizeof(double));
+
+    // Open the CSV data file
+    FILE *fp;
+    fp = fopen("Data/pipeline_data.csv", "w"); // Open for writing, overwriting if exists
+
+    if (fp == NULL)
+    {
+        printf("Error opening file!\n");
+        exit(1); // Exit with an error code
+    }
+
+    // Write header row. Staged runs one stage at a time over whole arrays, Fused runs every
+    // stage in a single pass over cache sized blocks
+    fprintf(fp, "Thread Count,Reps,Array Size,Pipeline");
+    bench_write_header(fp, "Staged");
+    bench_write_header(fp, "Fused");
+    fprintf(fp, ",Speedup,Result");
+    bench_write_binding(fp, true);
+    fprintf(fp, "\n");
+
+    for (int t = 0; t < cfg.n_thread_counts; t++)
+    {
+        int n_threads = cfg.threads[t];
+        int result = 0;
+
+        // Negative runs are the warm up runs and are not recorded
+        for (int rep = -cfg.warmup; rep < cfg.reps; rep++)
+        {
+            double start = omp_get_wtime();
+            int staged_result = pipeline_run_staged(&p, vals.data, len, n_threads);
+            double staged_time = omp_get_wtime() - start;
+
+            start = omp_get_wtime();
+            result = pipeline_run(&p, vals.data, len, n_threads);
+            double fused_time = omp_get_wtime() - start;
+
+            // Check that the two results are the same
+            assert(result == staged_result);
+
+            if (rep >= 0)
+            {
+                staged_samples[rep] = staged_time;
+                fused_samples[rep] = fused_time;
+            }
+        }
+
+        bench_stats staged = bench_summarize(staged_samples, cfg.reps);
+        bench_stats fused = bench_summarize(fused_samples, cfg.reps);
+        printf("%s, %d threads\n  Result: %d\n  Staged median: %lf\n  Fused median: %lf\n",
+               spec, n_threads, result, staged.median, fused.median);
+
+        // Write the data to the csv file. The pipeline is quoted because it contains commas
+        fprintf(fp, "%d,%d,%d,\"%s\"", n_threads, cfg.reps, len, spec);
+        bench_write_stats(fp, staged);
+        bench_write_stats(fp, fused);
+        fprintf(fp, ",%lf,%d", staged.median / fused.median, result);
+        bench_write_binding(fp, false);
+        fprintf(fp, "\n");
+    }
+
+    fclose(fp); // Close the file
+    printf("Data written to pipeline_data.csv successfully\n");
+
+    free(staged_samples);
+    free(fused_samples);
+    buffer_free(&vals);
+
+    return 0;
+}
@@ -5,49 +5,30 @@
 #include <math.h>
 #include <string.h>
 #include <assert.h>
+#include <stdbool.h>
+#include <unistd.h>
 
-// Basic operator functions
-int iadd(int x, int y) { return x + y; }
-int imult(int x, int y) { return x * y; }
-int imax(int x, int y) { return x > y ? x : y; }
-
-int gcd(int a, int b)
-{
-    if (a == 0)
-    {
-        return b;
-    }
-    else if (b == 0)
-    {
-        return a;
-    }
-
-    int result = ((a < b) ? a : b); // result = min(a, b)
-    while (result > 0)
-    {
-        if (a % result == 0 && b % result == 0)
-        {
-            break;
-        }
-        result--;
-    } // After exiting loop we have found gcd
-    return result;
-}
+#include "bench.h"
+#include "buffer.h"
+#include "profile.h"
+#include "reduction.h"
+#include "schedule.h"
+#include "wide_reduce.h"
 
 // serial_reduce() -> This function reduces a list of variables into one using a given operation function
 // INPUTS
-//  - int (*operator_func)(int x, int y) -> This is a pointer to a function that takes in two integers and returns an int
+//  - const reduce_operator* op -> The operator to reduce with (see reduction.h)
 //  - int vals[] -> This is a lit of integer values that will be reduced using the operator function
 //  - int len -> The length of the value array
-int serial_reduce(int (*operator_func)(int x, int y), int vals[], int len, double *serial_time)
+int serial_reduce(const reduce_operator *op, int vals[], int len, double *serial_time)
 {
-    int result = 0;
+    int result = op->identity;
 
     double start = omp_get_wtime();
 
     for (int i = 0; i < len; i++)
     {
-        result = operator_func(result, vals[i]);
+        result = op->func(result, vals[i]);
     }
     double end = omp_get_wtime();
     double time_diff = end - start;
@@ -62,25 +43,15 @@ int serial_reduce(int (*operator_func)(int x, int y), int vals[], int len, doubl
 
 // parallel_reduce() -> This function reduces a list of integer values into one using parallel loops
 // INPUTS
-//  - char operator -> The operator the should be used for the reduction
+//  - const reduce_operator* op -> The operator the should be used for the reduction
 //  - int vals[] -> This is a lit of integer values that will be reduced using the operator function
 //  - int len -> The length of the value array
-int parallel_reduce(int vals[], int len, int n_threads, double *parallel_time)
+//  - bool use_tree -> Whether to skip the operator's own kernel and use the tree combine fallback
+int parallel_reduce(const reduce_operator *op, int vals[], int len, int n_threads, bool use_tree, double *parallel_time)
 {
-    int i;
-    int result = 0;
-
     double start = omp_get_wtime();
 
-// #pragma omp declare reduction(                    \
-//         gcd:int : omp_out = gcd(omp_out, omp_in)) \
-//     initializer(omp_priv = 0)
-#pragma omp parallel for reduction(+ : result)
-    for (i = 0; i < len; i++)
-    {
-        // result = gcd(result, vals[i]);
-        result += vals[i];
-    }
+    int result = use_tree ? reduce_tree(op, vals, len, n_threads) : reduce_run(op, vals, len, n_threads);
 
     double end = omp_get_wtime();
     double time_diff = end - start;
@@ -92,22 +63,119 @@ int parallel_reduce(int vals[], int len, int n_threads, double *parallel_time)
     return result;
 }
 
+// reduce_trial -> The sample the schedule auto tuner runs reduce_run() on
+typedef struct
+{
+    const reduce_operator *op;
+    const int *sample;
+    int len;
+    int n_threads;
+} reduce_trial;
+
+// double time_reduce_trial() -> Runs reduce_run() once on the sample
+double time_reduce_trial(void *ctx)
+{
+    reduce_trial *trial = ctx;
+
+    double start = omp_get_wtime();
+    reduce_run(trial->op, trial->sample, trial->len, trial->n_threads);
+    return omp_get_wtime() - start;
+}
+
 int main(int argc, char *argv[])
 {
-    if (argc != 3) {
-        printf("Invalid Arguments: please pass length and MAX_VAL \n");
+    // -s picks the parallel loop schedule, e.g. -s guided or -s auto.
+    // The other options configure the benchmark harness (see bench.h)
+    schedule_policy policy = {omp_sched_static, 0, false};
+    bool tune = false;
+    bench_config cfg;
+    bench_defaults(&cfg);
+    int opt;
+    while ((opt = getopt(argc, argv, "s:" BENCH_OPTIONS)) != -1)
+    {
+        // The reduce kernels are cheap per element and do not support work stealing
+        if (opt == 's' ? !schedule_option(optarg, &policy, &tune) || policy.steal : !bench_option(opt, optarg, &cfg))
+        {
+            printf("Invalid Arguments: -s takes static, dynamic or guided (with an optional ,chunk) or auto \n");
+            printf("Usage: reduce [-s schedule] %s length MAX_VAL [operator] [input file] (or length MAX_VAL input file) \n", BENCH_USAGE);
+            return 1;
+        }
+    }
+    // Shift the arguments so the positional ones start at argv[1]
+    argc -= optind - 1;
+    argv += optind - 1;
+
+    if (argc < 3 || argc > 5) {
+        printf("Invalid Arguments: please pass [options] length and MAX_VAL (and optionally an operator and a binary input file) \n");
         return 1;
     }
+    bench_setup(&cfg);
+
     // Instantiate the basic variables for the reduction step
     // These will be taken from the command line
     int len = atoi(argv[1]);
     int MAX_VAL = atoi(argv[2]);
 
-    int vals[len];
-    for (int i = 0; i < len; i++)
+    // The operator is given as "name" or "name:tree" to force the tree combine fallback.
+    // With one optional argument that is not an operator but names a file, it is the input
+    // file, as it was before operators could be picked
+    const char *op_arg = "add";
+    const char *input_file = NULL;
+    if (argc == 5)
+    {
+        op_arg = argv[3];
+        input_file = argv[4];
+    }
+    else if (argc == 4)
     {
-        int random_val = (rand() % MAX_VAL) + 1;
-        vals[i] = random_val;
+        op_arg = argv[3];
+    }
+    char op_name[32];
+    snprintf(op_name, sizeof(op_name), "%s", op_arg);
+    bool use_tree = false;
+    char *suffix = strchr(op_name, ':');
+    if (suffix != NULL)
+    {
+        if (strcmp(suffix, ":tree") != 0)
+        {
+            printf("Invalid Arguments: %s is not an operator suffix, only :tree is \n", suffix);
+            return 1;
+        }
+        use_tree = true;
+        *suffix = '\0';
+    }
+    const reduce_operator *op = reduce_find(op_name);
+    if (op == NULL && argc == 4 && access(argv[3], R_OK) == 0)
+    {
+        input_file = argv[3];
+        op = reduce_find("add");
+    }
+    if (op == NULL)
+    {
+        printf("Unknown operator %s: please pass add, mult, max, min or gcd \n", op_name);
+        return 1;
+    }
+
+    // The input either comes from a memory mapped binary file or is generated on the heap
+    int_buffer vals;
+    if (input_file != NULL)
+    {
+        if (!buffer_map_file(input_file, &vals))
+        {
+            printf("Error mapping input file %s!\n", input_file);
+            exit(1);
+        }
+        // A length of 0 (or one longer than the file) means use the whole file
+        if (len > 0 && (size_t)len < vals.len)
+        {
+            vals.len = len;
+        }
+        len = vals.len;
+    }
+    else
+    {
+        vals = buffer_alloc(len, omp_get_max_threads());
+        bench_fill(&cfg, vals.data, len, MAX_VAL);
     }
 
     // Open the CSV data file
@@ -120,40 +188,96 @@ int main(int argc, char *argv[])
         exit(1); // Exit with an error code
     }
 
-    // Write header row
-    fprintf(fp, "Thread Count,Trial,Serial Time,Parallel Time, Array Size\n");
+    // Write header row. Every row summarizes the timed runs at one thread count
+    fprintf(fp, "Thread Count,Reps,Array Size,Operator");
+    bench_write_header(fp, "Serial");
+    bench_write_header(fp, "Parallel");
+    fprintf(fp, ",Speedup,Copy Time,Schedule,Chunk Size");
+    bench_write_binding(fp, true);
+    fprintf(fp, "\n");
 
-    for (int n_threads = 1; n_threads < 9; n_threads++)
+    // The working copy is allocated once and refilled every run
+    int_buffer parallel_vals = buffer_alloc(len, omp_get_max_threads());
+    double *serial_samples = malloc(cfg.reps * sizeof(double));
+    double *parallel_samples = malloc(cfg.reps * sizeof(double));
+    double *copy_samples = malloc(cfg.reps * sizeof(double));
+
+    // The serial baseline does not depend on the thread count, so it is timed once.
+    // Negative runs are the warm up runs and are not recorded
+    int serial_result = op->identity;
+    for (int rep = -cfg.warmup; rep < cfg.reps; rep++)
     {
-        for (int trial = 1; trial < 4; trial++)
+        double serial_time;
+        serial_result = serial_reduce(op, vals.data, len, &serial_time);
+        if (rep >= 0)
         {
-            // Create a list of random integer variables of length len with max value MAX_VAL
-            int serial_vals[len];
-            int parallel_vals[len];
+            serial_samples[rep] = serial_time;
+        }
+    }
+    bench_stats serial = bench_summarize(serial_samples, cfg.reps);
 
-            memcpy(serial_vals, vals, len * sizeof(int));
-            memcpy(parallel_vals, vals, len * sizeof(int));
+    // The int kernels wrap around on overflow. Check the exact result with the wide kernel
+    // so a wrapped result is not reported silently
+    int wide = wide_op_find(op->name);
+    if (wide >= 0 && wide_reduce(wide, vals.data, len, omp_get_max_threads()).overflow)
+    {
+        printf("Warning: the exact %s result does not fit in an int, the results have wrapped around \n", op->name);
+    }
 
-            double parallel_time;
-            double serial_time;
+    schedule_apply(&policy);
+    for (int t = 0; t < cfg.n_thread_counts; t++)
+    {
+        int n_threads = cfg.threads[t];
 
-            // Calculate parallel result
-            int parallel_result = parallel_reduce(parallel_vals, len, n_threads, &parallel_time);
+        // The best schedule depends on the thread count, so tune for every one
+        if (tune)
+        {
+            reduce_trial sample = {op, vals.data, len < SCHEDULE_SAMPLE_LEN ? len : SCHEDULE_SAMPLE_LEN, n_threads};
+            policy = schedule_autotune(time_reduce_trial, &sample);
+        }
 
-            // Calculate the serial result
-            int serial_result = serial_reduce(iadd, serial_vals, len, &serial_time);
+        for (int rep = -cfg.warmup; rep < cfg.reps; rep++)
+        {
+            // Copy the input into the working buffer and record what that costs
+            double copy_time = buffer_copy(&parallel_vals, &vals, n_threads);
+
+            // Calculate parallel result
+            double parallel_time;
+            int parallel_result = parallel_reduce(op, parallel_vals.data, len, n_threads, use_tree, &parallel_time);
 
             // Check that the two results are the same
             assert(parallel_result == serial_result);
-            printf("\nAssertion 1 passed: The two results are the same\n");
 
-            // Write the data to the csv file
-            fprintf(fp, "%d,%d,%lf,%lf,%d\n", n_threads, trial, serial_time, parallel_time, len);
+            if (rep >= 0)
+            {
+                parallel_samples[rep] = parallel_time;
+                copy_samples[rep] = copy_time;
+            }
         }
+        printf("\nAssertion 1 passed: The two results are the same\n");
+
+        bench_stats parallel = bench_summarize(parallel_samples, cfg.reps);
+        bench_stats copy = bench_summarize(copy_samples, cfg.reps);
+        printf("%d threads\n  Serial median: %lf\n  Parallel median: %lf (p95 %lf)\n", n_threads, serial.median, parallel.median, parallel.p95);
+
+        // Write the data to the csv file
+        fprintf(fp, "%d,%d,%d,%s%s", n_threads, cfg.reps, len, op->name, use_tree ? ":tree" : "");
+        bench_write_stats(fp, serial);
+        bench_write_stats(fp, parallel);
+        fprintf(fp, ",%lf,%lf,%s,%d", serial.median / parallel.median, copy.median, schedule_name(&policy), policy.chunk);
+        bench_write_binding(fp, false);
+        fprintf(fp, "\n");
     }
 
     fclose(fp); // Close the file
-    printf("Data written to people.csv successfully\n");
+    printf("Data written to reduce_data.csv successfully\n");
+    profile_write_report("Data/profile_data");
+
+    free(serial_samples);
+    free(parallel_samples);
+    free(copy_samples);
+    buffer_free(&parallel_vals);
+    buffer_free(&vals);
 
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,144 @@
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+
+#include "bench.h"
+#include "buffer.h"
+#include "scan.h"
+
+// long timed_scan() -> Runs an inclusive scan with the given variant and records how long it took
+//
+// INPUTS
+//  - const int in[] -> The values to scan
+//  - long out[] -> The output array
+//  - int len -> The length of the input array
+//  - scan_variant variant -> Which scan algorithm to use
+//  - int n_threads -> The number of threads to use
+//  - double* time -> Set to the time the scan took
+long timed_scan(const int in[], long out[], int len, scan_variant variant, int n_threads, double *time)
+{
+    double start = omp_get_wtime();
+    long total = inclusive_scan(in, out, len, variant, n_threads);
+    double end = omp_get_wtime();
+
+    *time = end - start;
+    return total;
+}
+
+int main(int argc, char *argv[])
+{
+    bench_config cfg;
+    bench_defaults(&cfg);
+    int opt;
+    while ((opt = getopt(argc, argv, BENCH_OPTIONS)) != -1)
+    {
+        if (!bench_option(opt, optarg, &cfg))
+        {
+            printf("Usage: scan %s length MAX_VAL \n", BENCH_USAGE);
+            return 1;
+        }
+    }
+    // Shift the arguments so the positional ones start at argv[1]
+    argc -= optind - 1;
+    argv += optind - 1;
+
+    if (argc != 3) {
+        printf("Invalid Arguments: please pass [options] length and MAX_VAL \n");
+        return 1;
+    }
+    bench_setup(&cfg);
+
+    int len = atoi(argv[1]);
+    int MAX_VAL = atoi(argv[2]);
+
+    int_buffer vals = buffer_alloc(len, omp_get_max_threads());
+    bench_fill(&cfg, vals.data, len, MAX_VAL);
+
+    // One output per variant so the results can be compared afterwards
+    long *serial_out = malloc((size_t)len * sizeof(long));
+    long *blocked_out = malloc((size_t)len * sizeof(long));
+    long *lookback_out = malloc((size_t)len * sizeof(long));
+    double *serial_samples = malloc(cfg.reps * sizeof(double));
+    double *parallel_samples = malloc(cfg.reps * sizeof(double));
+    double *lookback_samples = malloc(cfg.reps * sizeof(double));
+
+    // Open the CSV data file
+    FILE *fp;
+    fp = fopen("Data/scan_data.csv", "w"); // Open for writing, overwriting if exists
+
+    if (fp == NULL)
+    {
+        printf("Error opening file!\n");
+        exit(1); // Exit with an error code
+    }
+
+    // Write header row. Parallel is the blocked two pass scan, Lookback the single pass one
+    fprintf(fp, "Thread Count,Reps,Array Size,Distribution");
+    bench_write_header(fp, "Serial");
+    bench_write_header(fp, "Parallel");
+    bench_write_header(fp, "Lookback");
+    fprintf(fp, ",Speedup,Lookback Speedup");
+    bench_write_binding(fp, true);
+    fprintf(fp, "\n");
+
+    for (int t = 0; t < cfg.n_thread_counts; t++)
+    {
+        int n_threads = cfg.threads[t];
+
+        // Negative runs are the warm up runs and are not recorded
+        for (int rep = -cfg.warmup; rep < cfg.reps; rep++)
+        {
+            double serial_time;
+            double parallel_time;
+            double lookback_time;
+
+            long serial_total = timed_scan(vals.data, serial_out, len, SCAN_SERIAL, 1, &serial_time);
+            long parallel_total = timed_scan(vals.data, blocked_out, len, SCAN_BLOCKED, n_threads, &parallel_time);
+            long lookback_total = timed_scan(vals.data, lookback_out, len, SCAN_LOOKBACK, n_threads, &lookback_time);
+
+            // Check that the three scans are the same
+            assert(parallel_total == serial_total && lookback_total == serial_total);
+            assert(memcmp(blocked_out, serial_out, (size_t)len * sizeof(long)) == 0);
+            assert(memcmp(lookback_out, serial_out, (size_t)len * sizeof(long)) == 0);
+
+            if (rep >= 0)
+            {
+                serial_samples[rep] = serial_time;
+                parallel_samples[rep] = parallel_time;
+                lookback_samples[rep] = lookback_time;
+            }
+        }
+
+        bench_stats serial = bench_summarize(serial_samples, cfg.reps);
+        bench_stats parallel = bench_summarize(parallel_samples, cfg.reps);
+        bench_stats lookback = bench_summarize(lookback_samples, cfg.reps);
+        printf("%d threads\n  Serial median: %lf\n  Parallel median: %lf\n  Lookback median: %lf\n",
+               n_threads, serial.median, parallel.median, lookback.median);
+
+        // Write the data to the csv file
+        fprintf(fp, "%d,%d,%d,%s", n_threads, cfg.reps, len, rng_name(&cfg.dist));
+        bench_write_stats(fp, serial);
+        bench_write_stats(fp, parallel);
+        bench_write_stats(fp, lookback);
+        fprintf(fp, ",%lf,%lf", serial.median / parallel.median, serial.median / lookback.median);
+        bench_write_binding(fp, false);
+        fprintf(fp, "\n");
+    }
+    printf("The three scans gave the same results\n");
+
+    fclose(fp); // Close the file
+    printf("Data written to scan_data.csv successfully\n");
+
+    free(serial_out);
+    free(blocked_out);
+    free(lookback_out);
+    free(serial_samples);
+    free(parallel_samples);
+    free(lookback_samples);
+    buffer_free(&vals);
+
+    return 0;
+}
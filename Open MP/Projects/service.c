@@ -0,0 +1,399 @@
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+
+#include "bench.h"
+#include "buffer.h"
+#include "pipeline.h"
+#include "service.h"
+#include "stream.h"
+
+// The most clients connected at once
+#define MAX_CLIENTS 64
+
+// The chunk length .csv inputs are parsed with
+#define LOAD_CHUNK_LEN (1024 * 1024)
+
+// partial_request -> A request read from a client so far
+//
+// FIELDS
+//  - service_request req -> The request
+//  - size_t got -> How many of its bytes have arrived
+typedef struct
+{
+    service_request req;
+    size_t got;
+} partial_request;
+
+// service_state -> What the service keeps between jobs
+//
+// FIELDS
+//  - int n_threads -> The size of the thread pool every job runs on
+//  - int_buffer file -> The values of the last file a job used
+//  - char file_path[] -> Its path, empty if nothing is loaded
+//  - struct stat file_stat -> Its size and modification time when it was loaded, to notice changes
+//  - int_buffer scratch -> Where file values are mapped and filtered, so the cached copy stays intact
+//  - long jobs, failed -> The jobs served so far and how many of them failed
+//  - double compute_time -> The time all the jobs spent in the kernels
+typedef struct
+{
+    int n_threads;
+    int_buffer file;
+    char file_path[SERVICE_MAX_SOURCE];
+    struct stat file_stat;
+    int_buffer scratch;
+    long jobs;
+    long failed;
+    double compute_time;
+} service_state;
+
+// Set by SIGINT and SIGTERM
+static volatile sig_atomic_t stopping = 0;
+
+static void handle_stop(int sig)
+{
+    (void)sig;
+    stopping = 1;
+}
+
+// void reserve() -> Makes buf hold at least len ints, keeping its contents. Buffers only ever grow,
+//  so once the service has seen its largest job it stops allocating
+void reserve(int_buffer *buf, size_t len, int n_threads)
+{
+    if (buf->data != NULL && buf->len >= len)
+    {
+        return;
+    }
+
+    size_t new_len = buf->len * 2 > len ? buf->len * 2 : len;
+    int_buffer bigger = buffer_alloc(new_len, n_threads);
+    if (buf->data != NULL)
+    {
+        memcpy(bigger.data, buf->data, buf->len * sizeof(int));
+        buffer_free(buf);
+    }
+    *buf = bigger;
+}
+
+// bool load_file() -> Makes state->file hold the values of path, unless it already does and the
+//  file has not changed. Binary files are memory mapped, .csv files parsed into a heap buffer
+//
+// Returns false if the file cannot be read
+bool load_file(service_state *state, const char *path)
+{
+    struct stat st;
+    if (stat(path, &st) != 0)
+    {
+        return false;
+    }
+    if (strcmp(state->file_path, path) == 0 && st.st_size == state->file_stat.st_size &&
+        st.st_mtime == state->file_stat.st_mtime)
+    {
+        return true;
+    }
+
+    buffer_free(&state->file);
+    state->file_path[0] = '\0';
+
+    size_t n = strlen(path);
+    if (n < 4 || strcmp(path + n - 4, ".csv") != 0)
+    {
+        if (!buffer_map_file(path, &state->file))
+        {
+            return false;
+        }
+    }
+    else
+    {
+        stream s;
+        if (!stream_open(path, LOAD_CHUNK_LEN, state->n_threads, &s))
+        {
+            return false;
+        }
+        int_buffer values = {NULL, 0, false};
+        size_t filled = 0;
+        int *chunk;
+        size_t len;
+        while (stream_next(&s, &chunk, &len))
+        {
+            reserve(&values, filled + len, state->n_threads);
+            memcpy(values.data + filled, chunk, len * sizeof(int));
+            filled += len;
+        }
+        bool bad_value = s.bad_value;
+        stream_close(&s);
+        if (bad_value)
+        {
+            buffer_free(&values);
+            return false;
+        }
+        if (values.data == NULL)
+        {
+            values = buffer_alloc(1, state->n_threads);
+        }
+        values.len = filled;
+        state->file = values;
+    }
+
+    strcpy(state->file_path, path);
+    state->file_stat = st;
+    return true;
+}
+
+// void fail() -> Fills in a failed reply
+void fail(service_reply *reply, const char *what, const char *name)
+{
+    reply->status = 1;
+    snprintf(reply->error, sizeof(reply->error), "%s %s", what, name);
+}
+
+// void run_job() -> Runs one request on the thread pool and fills in its reply
+void run_job(service_state *state, service_request *req, service_reply *reply)
+{
+    memset(reply, 0, sizeof(*reply));
+    req->pipeline[SERVICE_MAX_PIPELINE - 1] = '\0';
+    req->source_name[SERVICE_MAX_SOURCE - 1] = '\0';
+
+    pipeline p;
+    if (!pipeline_parse(req->pipeline, &p))
+    {
+        fail(reply, "Invalid pipeline", req->pipeline);
+        return;
+    }
+
+    int *vals;
+    long len;
+    void *segment = NULL;
+    size_t segment_size = 0;
+    if (req->source == SERVICE_SHM)
+    {
+        int fd = shm_open(req->source_name, O_RDWR, 0);
+        struct stat st;
+        if (fd < 0 || fstat(fd, &st) != 0)
+        {
+            if (fd >= 0)
+            {
+                close(fd);
+            }
+            fail(reply, "Cannot open shared memory segment", req->source_name);
+            return;
+        }
+        segment_size = st.st_size;
+        len = (long)(segment_size / sizeof(int));
+        if (req->len > 0 && req->len < len)
+        {
+            len = req->len;
+        }
+        segment = segment_size > 0 ? mmap(NULL, segment_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : NULL;
+        close(fd);
+        if (segment == MAP_FAILED || segment == NULL)
+        {
+            fail(reply, "Cannot map shared memory segment", req->source_name);
+            return;
+        }
+        vals = segment;
+    }
+    else
+    {
+        if (!load_file(state, req->source_name))
+        {
+            fail(reply, "Cannot read input file", req->source_name);
+            return;
+        }
+        len = (long)state->file.len;
+        vals = state->file.data;
+        if (p.reduce == NULL)
+        {
+            // Map and filter in a reused copy so the cached values stay as they are in the file
+            reserve(&state->scratch, len > 0 ? len : 1, state->n_threads);
+            memcpy(state->scratch.data, vals, len * sizeof(int));
+            vals = state->scratch.data;
+        }
+    }
+
+    double start = omp_get_wtime();
+    if (p.reduce != NULL)
+    {
+        reply->result = pipeline_run(&p, vals, len, state->n_threads);
+    }
+    else
+    {
+        reply->survivors = pipeline_apply(&p, vals, len, state->n_threads);
+    }
+    reply->compute_time = omp_get_wtime() - start;
+    reply->elements = len;
+
+    if (segment != NULL)
+    {
+        munmap(segment, segment_size);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    // -s sets the socket path, -n the size of the thread pool, -b and -p how it is pinned
+    const char *socket_path = SERVICE_SOCKET;
+    int n_threads = 0;
+    const char *bind = "close";
+    const char *places = "cores";
+    int opt;
+    while ((opt = getopt(argc, argv, "s:n:b:p:")) != -1)
+    {
+        if (opt == 's')
+        {
+            socket_path = optarg;
+        }
+        else if (opt == 'n' && atoi(optarg) > 0)
+        {
+            n_threads = atoi(optarg);
+        }
+        else if (opt == 'b')
+        {
+            bind = optarg;
+        }
+        else if (opt == 'p')
+        {
+            places = optarg;
+        }
+        else
+        {
+            printf("Usage: service [-s socket path] [-n threads] [-b OMP_PROC_BIND] [-p OMP_PLACES] \n");
+            return 1;
+        }
+    }
+
+    // Pin the pool before OpenMP starts, unless the environment already says how. OpenMP only
+    // reads the settings at load time, so this restarts the service if it changes them
+    bench_bind(bind, places, false);
+    if (n_threads == 0)
+    {
+        n_threads = omp_get_max_threads();
+    }
+
+    int listener = service_listen(socket_path);
+    if (listener < 0)
+    {
+        printf("Error listening on %s!\n", socket_path);
+        exit(1);
+    }
+
+    // A client hanging up mid reply must not take the service down with it
+    signal(SIGPIPE, SIG_IGN);
+    struct sigaction stop = {0};
+    stop.sa_handler = handle_stop;
+    sigaction(SIGINT, &stop, NULL);
+    sigaction(SIGTERM, &stop, NULL);
+
+    service_state state;
+    memset(&state, 0, sizeof(state));
+    state.n_threads = n_threads;
+
+    // Start the pool now so the first job does not pay for creating it
+#pragma omp parallel num_threads(n_threads)
+    {
+    }
+    printf("Serving on %s with %d threads (bind %s, %d places)\n", socket_path, n_threads, bench_proc_bind_name(),
+           omp_get_num_places());
+    fflush(stdout);
+
+    // fds[0] is the listening socket, the rest are clients. Every pass serves at most one request
+    // per client, so a client sending a burst of jobs cannot shut the others out. The clients are
+    // non blocking and pending[i] collects client i's request across reads, so one that sends only
+    // part of a request does not stall the rest
+    struct pollfd fds[MAX_CLIENTS + 1];
+    partial_request pending[MAX_CLIENTS + 1];
+    int n_fds = 1;
+    fds[0].fd = listener;
+    fds[0].events = POLLIN;
+
+    while (!stopping)
+    {
+        if (poll(fds, n_fds, -1) < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            printf("Error waiting for requests!\n");
+            exit(1);
+        }
+
+        for (int i = n_fds - 1; i >= 1; i--)
+        {
+            if (fds[i].revents == 0)
+            {
+                continue;
+            }
+
+            partial_request *part = &pending[i];
+            ssize_t n = read(fds[i].fd, (char *)&part->req + part->got, sizeof(part->req) - part->got);
+            bool open = n > 0 || (n < 0 && (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK));
+            part->got += n > 0 ? (size_t)n : 0;
+            if (open && part->got == sizeof(part->req))
+            {
+                service_request req = part->req;
+                service_reply reply;
+                part->got = 0;
+                if (req.source == SERVICE_SHUTDOWN)
+                {
+                    memset(&reply, 0, sizeof(reply));
+                    stopping = 1;
+                }
+                else
+                {
+                    run_job(&state, &req, &reply);
+                    state.jobs++;
+                    state.failed += reply.status != 0;
+                    state.compute_time += reply.compute_time;
+                }
+                open = service_send(fds[i].fd, &reply, sizeof(reply));
+            }
+
+            if (!open)
+            {
+                close(fds[i].fd);
+                n_fds--;
+                fds[i] = fds[n_fds];
+                pending[i] = pending[n_fds];
+            }
+        }
+
+        if (fds[0].revents & POLLIN)
+        {
+            int client = accept(listener, NULL, NULL);
+            if (client >= 0 && n_fds == MAX_CLIENTS + 1)
+            {
+                close(client);
+            }
+            else if (client >= 0)
+            {
+                fcntl(client, F_SETFL, fcntl(client, F_GETFL) | O_NONBLOCK);
+                pending[n_fds].got = 0;
+                fds[n_fds].fd = client;
+                fds[n_fds].events = POLLIN;
+                fds[n_fds].revents = 0;
+                n_fds++;
+            }
+        }
+    }
+
+    for (int i = 0; i < n_fds; i++)
+    {
+        close(fds[i].fd);
+    }
+    unlink(socket_path);
+    buffer_free(&state.file);
+    buffer_free(&state.scratch);
+
+    printf("Served %ld jobs (%ld failed), %lf seconds in the kernels\n", state.jobs, state.failed, state.compute_time);
+    return 0;
+}
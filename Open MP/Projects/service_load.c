@@ -0,0 +1,305 @@
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "buffer.h"
+#include "pipeline.h"
+#include "rng.h"
+#include "service.h"
+
+static int compare_doubles(const void *a, const void *b)
+{
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// double percentile() -> The nearest rank p-th percentile of sorted[0, n)
+double percentile(const double sorted[], long n, double p)
+{
+    long rank = (long)ceil(p / 100 * n);
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+int main(int argc, char *argv[])
+{
+    // -s sets the socket path, -c the number of concurrent connections, -j the timed jobs each
+    // connection sends per pipeline, -w its untimed warm up jobs, -f a binary file to write the
+    // input to and send file jobs for instead of shared memory jobs, and -S shuts the service
+    // down afterwards
+    const char *socket_path = SERVICE_SOCKET;
+    int connections = 1;
+    int jobs = 1000;
+    int warmup = 10;
+    const char *file_path = NULL;
+    bool shutdown = false;
+    int opt;
+    while ((opt = getopt(argc, argv, "s:c:j:w:f:S")) != -1)
+    {
+        if (opt == 's')
+        {
+            socket_path = optarg;
+        }
+        else if (opt == 'c' && atoi(optarg) > 0)
+        {
+            connections = atoi(optarg);
+        }
+        else if (opt == 'j' && atoi(optarg) > 0)
+        {
+            jobs = atoi(optarg);
+        }
+        else if (opt == 'w' && atoi(optarg) >= 0)
+        {
+            warmup = atoi(optarg);
+        }
+        else if (opt == 'f')
+        {
+            file_path = optarg;
+        }
+        else if (opt == 'S')
+        {
+            shutdown = true;
+        }
+        else
+        {
+            printf("Usage: service_load [-s socket path] [-c connections] [-j jobs] [-w warm up jobs] [-f input file] [-S] length MAX_VAL pipeline... \n");
+            return 1;
+        }
+    }
+    // Shift the arguments so the positional ones start at argv[1]
+    argc -= optind - 1;
+    argv += optind - 1;
+
+    if (argc < 4) {
+        printf("Invalid Arguments: please pass [options] length, MAX_VAL and at least one pipeline \n");
+        return 1;
+    }
+    long len = atol(argv[1]);
+    int MAX_VAL = atoi(argv[2]);
+    int n_pipelines = argc - 3;
+    char **specs = argv + 3;
+
+    pipeline *pipelines = malloc(n_pipelines * sizeof(pipeline));
+    for (int i = 0; i < n_pipelines; i++)
+    {
+        if (strlen(specs[i]) >= SERVICE_MAX_PIPELINE || !pipeline_parse(specs[i], &pipelines[i]))
+        {
+            printf("Invalid Arguments: %s is not a pipeline \n", specs[i]);
+            return 1;
+        }
+    }
+
+    // Every job works on the same values, so the results can be checked against a local run
+    rng_distribution uniform = {RNG_UNIFORM, 1.0};
+    int_buffer input = buffer_alloc(len, omp_get_max_threads());
+    rng_fill(&uniform, RNG_DEFAULT_SEED, input.data, len, MAX_VAL, omp_get_max_threads());
+
+    if (file_path != NULL)
+    {
+        FILE *out = fopen(file_path, "wb");
+        if (out == NULL || fwrite(input.data, sizeof(int), len, out) != (size_t)len)
+        {
+            printf("Error writing input file %s!\n", file_path);
+            exit(1);
+        }
+        fclose(out);
+    }
+
+    // Each connection gets its own segment, since jobs without a reduction rewrite theirs
+    char (*names)[SERVICE_MAX_SOURCE] = malloc(connections * sizeof(*names));
+    int **segments = malloc(connections * sizeof(int *));
+    size_t segment_size = (len > 0 ? len : 1) * sizeof(int);
+    for (int c = 0; c < connections && file_path == NULL; c++)
+    {
+        snprintf(names[c], SERVICE_MAX_SOURCE, "/omp_service_%d_%d", (int)getpid(), c);
+        int fd = shm_open(names[c], O_CREAT | O_RDWR, 0600);
+        if (fd < 0 || ftruncate(fd, segment_size) != 0)
+        {
+            printf("Error creating shared memory segment %s!\n", names[c]);
+            exit(1);
+        }
+        segments[c] = mmap(NULL, segment_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (segments[c] == MAP_FAILED)
+        {
+            printf("Error mapping shared memory segment %s!\n", names[c]);
+            exit(1);
+        }
+    }
+
+    int *fds = malloc(connections * sizeof(int));
+    for (int c = 0; c < connections; c++)
+    {
+        fds[c] = service_connect(socket_path);
+        if (fds[c] < 0)
+        {
+            printf("Error connecting to %s, is the service running?\n", socket_path);
+            exit(1);
+        }
+    }
+
+    double *latencies = malloc((size_t)connections * jobs * sizeof(double));
+    double *compute_times = malloc((size_t)connections * jobs * sizeof(double));
+    int_buffer expected_vals = buffer_alloc(len > 0 ? len : 1, omp_get_max_threads());
+
+    // Open the CSV data file
+    FILE *fp;
+    fp = fopen("Data/service_data.csv", "w"); // Open for writing, overwriting if exists
+
+    if (fp == NULL)
+    {
+        printf("Error opening file!\n");
+        exit(1); // Exit with an error code
+    }
+
+    // Write header row. Latencies are in microseconds, measured by the client from sending a
+    // request to reading its reply. Compute Mean is the part of that the service spent in the
+    // kernels, the rest is the socket round trip, queueing behind other connections and loading
+    // the input. The pipeline is quoted because it contains commas
+    fprintf(fp, "Connections,Jobs Per Connection,Pipeline,Source,Array Size,Jobs Per Sec,Latency P50,Latency P90,Latency P99,Latency Max,Latency Mean,Compute Mean\n");
+
+    for (int i = 0; i < n_pipelines; i++)
+    {
+        const pipeline *p = &pipelines[i];
+        int expected = 0;
+        long long expected_survivors = 0;
+        if (p->reduce != NULL)
+        {
+            expected = pipeline_run(p, input.data, len, 1);
+        }
+        else
+        {
+            memcpy(expected_vals.data, input.data, len * sizeof(int));
+            expected_survivors = pipeline_apply(p, expected_vals.data, len, 1);
+        }
+
+        int failures = 0;
+        double start = 0;
+        double end = 0;
+#pragma omp parallel num_threads(connections) reduction(+ : failures)
+        {
+            int c = omp_get_thread_num();
+            service_request req;
+            memset(&req, 0, sizeof(req));
+            req.source = file_path != NULL ? SERVICE_FILE : SERVICE_SHM;
+            req.len = len;
+            strcpy(req.pipeline, specs[i]);
+            strcpy(req.source_name, file_path != NULL ? file_path : names[c]);
+
+            // Negative jobs are the warm up jobs and are not recorded
+            for (int job = -warmup; job < jobs; job++)
+            {
+                if (job == 0)
+                {
+#pragma omp barrier
+#pragma omp single
+                    start = omp_get_wtime();
+                }
+
+                // Put back the input a previous map or filter job rewrote
+                if (file_path == NULL && (p->reduce == NULL || job == -warmup))
+                {
+                    memcpy(segments[c], input.data, len * sizeof(int));
+                }
+
+                service_reply reply;
+                double sent = omp_get_wtime();
+                if (!service_send(fds[c], &req, sizeof(req)) || !service_recv(fds[c], &reply, sizeof(reply)))
+                {
+                    printf("Error talking to the service!\n");
+                    exit(1);
+                }
+                double latency = omp_get_wtime() - sent;
+
+                bool correct = reply.status == 0 && reply.elements == len &&
+                               (p->reduce != NULL ? reply.result == expected : reply.survivors == expected_survivors);
+                if (correct && p->reduce == NULL && file_path == NULL)
+                {
+                    correct = memcmp(segments[c], expected_vals.data, expected_survivors * sizeof(int)) == 0;
+                }
+                if (!correct)
+                {
+                    failures++;
+                    if (reply.status != 0)
+                    {
+                        printf("Job failed: %s\n", reply.error);
+                    }
+                }
+
+                if (job >= 0)
+                {
+                    latencies[(size_t)c * jobs + job] = latency;
+                    compute_times[(size_t)c * jobs + job] = reply.compute_time;
+                }
+            }
+
+#pragma omp barrier
+#pragma omp single
+            end = omp_get_wtime();
+        }
+
+        long n = (long)connections * jobs;
+        double compute_sum = 0;
+        double latency_sum = 0;
+        for (long j = 0; j < n; j++)
+        {
+            compute_sum += compute_times[j];
+            latency_sum += latencies[j];
+        }
+        qsort(latencies, n, sizeof(double), compare_doubles);
+        double rate = n / (end - start);
+        printf("%s, %d connection(s)%s\n  Jobs/sec: %.0lf\n  Latency p50/p90/p99/max: %.1lf/%.1lf/%.1lf/%.1lf us\n  Mean compute: %.1lf us\n",
+               specs[i], connections, failures > 0 ? " (WRONG RESULTS)" : "", rate, percentile(latencies, n, 50) * 1e6,
+               percentile(latencies, n, 90) * 1e6, percentile(latencies, n, 99) * 1e6, latencies[n - 1] * 1e6,
+               compute_sum / n * 1e6);
+        if (failures > 0)
+        {
+            printf("Error: %d jobs returned the wrong result!\n", failures);
+            exit(1);
+        }
+
+        // Write the data to the csv file
+        fprintf(fp, "%d,%d,\"%s\",%s,%ld,%lf,%lf,%lf,%lf,%lf,%lf,%lf\n", connections, jobs, specs[i],
+                file_path != NULL ? "file" : "shm", len, rate, percentile(latencies, n, 50) * 1e6,
+                percentile(latencies, n, 90) * 1e6, percentile(latencies, n, 99) * 1e6, latencies[n - 1] * 1e6,
+                latency_sum / n * 1e6, compute_sum / n * 1e6);
+    }
+
+    fclose(fp); // Close the file
+    printf("Data written to service_data.csv successfully\n");
+
+    if (shutdown)
+    {
+        service_request req;
+        service_reply reply;
+        memset(&req, 0, sizeof(req));
+        req.source = SERVICE_SHUTDOWN;
+        service_send(fds[0], &req, sizeof(req));
+        service_recv(fds[0], &reply, sizeof(reply));
+    }
+
+    for (int c = 0; c < connections; c++)
+    {
+        close(fds[c]);
+        if (file_path == NULL)
+        {
+            munmap(segments[c], segment_size);
+            shm_unlink(names[c]);
+        }
+    }
+    free(pipelines);
+    free(names);
+    free(segments);
+    free(fds);
+    free(latencies);
+    free(compute_times);
+    buffer_free(&input);
+    buffer_free(&expected_vals);
+
+    return 0;
+}
@@ -0,0 +1,188 @@
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+
+#include "bench.h"
+#include "buffer.h"
+#include "pipeline.h"
+#include "reduction.h"
+#include "schedule.h"
+#include "shard.h"
+
+int main(int argc, char *argv[])
+{
+    bench_config cfg;
+    bench_defaults(&cfg);
+    // -n takes the process counts, in the same list form as the thread counts
+    bench_config processes;
+    bench_defaults(&processes);
+    processes.n_thread_counts = 4;
+    for (int i = 0; i < 4; i++)
+    {
+        processes.threads[i] = 1 << i;
+    }
+    int opt;
+    while ((opt = getopt(argc, argv, BENCH_OPTIONS "n:")) != -1)
+    {
+        bool valid = opt == 'n' ? bench_option('t', optarg, &processes) : bench_option(opt, optarg, &cfg);
+        if (!valid)
+        {
+            printf("Usage: shard_bench %s [-n process list e.g. 1,2,4] length MAX_VAL [operator] [predicate] \n", BENCH_USAGE);
+            return 1;
+        }
+    }
+    // Shift the arguments so the positional ones start at argv[1]
+    argc -= optind - 1;
+    argv += optind - 1;
+
+    if (argc < 3 || argc > 5) {
+        printf("Invalid Arguments: please pass [options] length and MAX_VAL, and optionally an operator (add, mult, max, min, gcd) and a predicate (even, odd, positive) \n");
+        return 1;
+    }
+    bench_setup(&cfg);
+
+    long len = atol(argv[1]);
+    int MAX_VAL = atoi(argv[2]);
+    const reduce_operator *op = reduce_find(argc > 3 ? argv[3] : "add");
+    const char *predicate = argc > 4 ? argv[4] : "even";
+    if (op == NULL || pipeline_predicate(predicate) == NULL)
+    {
+        printf("Invalid Arguments: unknown operator or predicate \n");
+        return 1;
+    }
+
+    // Both sides follow the static schedule, and the workers inherit it when they are forked
+    schedule_policy policy = {omp_sched_static, 0, false};
+    schedule_apply(&policy);
+
+    // The workers have to be forked before this process starts its own OpenMP threads
+    int max_processes = 1;
+    for (int i = 0; i < processes.n_thread_counts; i++)
+    {
+        max_processes = processes.threads[i] > max_processes ? processes.threads[i] : max_processes;
+    }
+    shard_pool pool;
+    if (!shard_pool_create(&pool, max_processes, len))
+    {
+        printf("Error starting %d worker processes!\n", max_processes);
+        exit(1);
+    }
+
+    // The threaded runs read the same shared input the workers do
+    bench_fill(&cfg, pool.input, len, MAX_VAL);
+    int_buffer input = {pool.input, len, false};
+    int_buffer threaded_out = buffer_alloc(len, omp_get_max_threads());
+    char spec[64];
+    snprintf(spec, sizeof(spec), "filter:%s", predicate);
+    pipeline filter;
+    pipeline_parse(spec, &filter);
+
+    double *samples[4];
+    for (int i = 0; i < 4; i++)
+    {
+        samples[i] = malloc(cfg.reps * sizeof(double));
+    }
+
+    // Open the CSV data file
+    FILE *fp;
+    fp = fopen("Data/shard_data.csv", "w"); // Open for writing, overwriting if exists
+
+    if (fp == NULL)
+    {
+        printf("Error opening file!\n");
+        exit(1); // Exit with an error code
+    }
+
+    // Write header row. Thread Count is the total number of threads, which the sharded runs split
+    // evenly over Processes. The Threaded series run all of them in this process
+    fprintf(fp, "Thread Count,Processes,Threads Per Process,Reps,Array Size,Operator,Predicate");
+    bench_write_header(fp, "Threaded Reduce");
+    bench_write_header(fp, "Sharded Reduce");
+    bench_write_header(fp, "Threaded Filter");
+    bench_write_header(fp, "Sharded Filter");
+    fprintf(fp, ",Reduce Ratio,Filter Ratio,Survivors");
+    bench_write_binding(fp, true);
+    fprintf(fp, "\n");
+
+    for (int t = 0; t < cfg.n_thread_counts; t++)
+    {
+        int n_threads = cfg.threads[t];
+        for (int i = 0; i < processes.n_thread_counts; i++)
+        {
+            int n_processes = processes.threads[i];
+            if (n_processes > n_threads || n_threads % n_processes != 0)
+            {
+                continue;
+            }
+            int per_process = n_threads / n_processes;
+            long survivors = 0;
+
+            // Negative runs are the warm up runs and are not recorded
+            for (int rep = -cfg.warmup; rep < cfg.reps; rep++)
+            {
+                double start = omp_get_wtime();
+                int threaded_result = reduce_run(op, pool.input, (int)len, n_threads);
+                double threaded_reduce = omp_get_wtime() - start;
+
+                start = omp_get_wtime();
+                int sharded_result = shard_reduce(&pool, op, len, n_processes, per_process);
+                double sharded_reduce = omp_get_wtime() - start;
+
+                start = omp_get_wtime();
+                buffer_copy(&threaded_out, &input, n_threads);
+                long threaded_count = pipeline_apply(&filter, threaded_out.data, len, n_threads);
+                double threaded_filter = omp_get_wtime() - start;
+
+                start = omp_get_wtime();
+                survivors = shard_filter(&pool, predicate, len, n_processes, per_process);
+                double sharded_filter = omp_get_wtime() - start;
+
+                // Both sides have to agree on the result and on every survivor
+                assert(threaded_result == sharded_result);
+                assert(threaded_count == survivors);
+                assert(memcmp(threaded_out.data, pool.output, survivors * sizeof(int)) == 0);
+
+                if (rep >= 0)
+                {
+                    samples[0][rep] = threaded_reduce;
+                    samples[1][rep] = sharded_reduce;
+                    samples[2][rep] = threaded_filter;
+                    samples[3][rep] = sharded_filter;
+                }
+            }
+
+            bench_stats stats[4];
+            for (int s = 0; s < 4; s++)
+            {
+                stats[s] = bench_summarize(samples[s], cfg.reps);
+            }
+            printf("%d threads as %d process(es) x %d\n  Reduce threaded/sharded: %lf / %lf\n  Filter threaded/sharded: %lf / %lf\n",
+                   n_threads, n_processes, per_process, stats[0].median, stats[1].median, stats[2].median, stats[3].median);
+
+            // Write the data to the csv file
+            fprintf(fp, "%d,%d,%d,%d,%ld,%s,%s", n_threads, n_processes, per_process, cfg.reps, len, op->name, predicate);
+            for (int s = 0; s < 4; s++)
+            {
+                bench_write_stats(fp, stats[s]);
+            }
+            fprintf(fp, ",%lf,%lf,%ld", stats[1].median / stats[0].median, stats[3].median / stats[2].median, survivors);
+            bench_write_binding(fp, false);
+            fprintf(fp, "\n");
+        }
+    }
+
+    fclose(fp); // Close the file
+    printf("Data written to shard_data.csv successfully\n");
+
+    for (int i = 0; i < 4; i++)
+    {
+        free(samples[i]);
+    }
+    buffer_free(&threaded_out);
+    shard_pool_destroy(&pool);
+
+    return 0;
+}
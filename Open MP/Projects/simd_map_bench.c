@@ -0,0 +1,150 @@
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+
+#include "bench.h"
+#include "buffer.h"
+#include "simd_map.h"
+
+// pointer_map() -> The baseline: the same loop as parallel_map() in map.c, calling the operator
+//  through a function pointer. noinline keeps the compiler from seeing which function it is
+// INPUTS
+//  - int (*operator_func)(int x) -> The operator to apply
+//  - int vals[] -> The values to map in place
+//  - int len -> The length of the value array
+//  - int n_threads -> The number of threads to use
+__attribute__((noinline)) void pointer_map(int (*operator_func)(int x), int vals[], int len, int n_threads)
+{
+#pragma omp parallel for schedule(static) num_threads(n_threads)
+    for (int i = 0; i < len; i++)
+    {
+        vals[i] = operator_func(vals[i]);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    bench_config cfg;
+    bench_defaults(&cfg);
+    int opt;
+    while ((opt = getopt(argc, argv, BENCH_OPTIONS)) != -1)
+    {
+        if (!bench_option(opt, optarg, &cfg))
+        {
+            printf("Usage: simd_map_bench %s length MAX_VAL \n", BENCH_USAGE);
+            return 1;
+        }
+    }
+    // Shift the arguments so the positional ones start at argv[1]
+    argc -= optind - 1;
+    argv += optind - 1;
+
+    if (argc != 3) {
+        printf("Invalid Arguments: please pass [options] length and MAX_VAL \n");
+        return 1;
+    }
+    bench_setup(&cfg);
+
+    int len = atoi(argv[1]);
+    int MAX_VAL = atoi(argv[2]);
+
+    // Values in [-MAX_VAL, MAX_VAL] so count and abs have negatives to deal with
+    int_buffer vals = buffer_alloc(len, omp_get_max_threads());
+    bench_fill(&cfg, vals.data, len, 2 * MAX_VAL + 1);
+#pragma omp parallel for schedule(static)
+    for (int i = 0; i < len; i++)
+    {
+        vals.data[i] -= MAX_VAL + 1;
+    }
+    int_buffer pointer_vals = buffer_alloc(len, omp_get_max_threads());
+    int_buffer simd_vals = buffer_alloc(len, omp_get_max_threads());
+    double *pointer_samples = malloc(cfg.reps * sizeof(double));
+    double *simd_samples = malloc(cfg.reps * sizeof(double));
+
+    // Open the CSV data file
+    FILE *fp;
+    fp = fopen("Data/simd_map_data.csv", "w"); // Open for writing, overwriting if exists
+
+    if (fp == NULL)
+    {
+        printf("Error opening file!\n");
+        exit(1); // Exit with an error code
+    }
+
+    // Write header row. Pointer is the function pointer baseline, Specialized the kernel for the ISA
+    fprintf(fp, "Thread Count,Reps,Array Size,Operator,ISA");
+    bench_write_header(fp, "Pointer");
+    bench_write_header(fp, "Specialized");
+    fprintf(fp, ",Speedup");
+    bench_write_binding(fp, true);
+    fprintf(fp, "\n");
+
+    printf("Best ISA on this CPU: %s\n", map_isa_name(map_isa_best()));
+
+    for (int op = 0; op < MAP_N_OPS; op++)
+    {
+        for (int isa = 0; isa < MAP_N_ISAS; isa++)
+        {
+            if (!map_isa_supported(isa))
+            {
+                continue;
+            }
+
+            for (int t = 0; t < cfg.n_thread_counts; t++)
+            {
+                int n_threads = cfg.threads[t];
+
+                // Negative runs are the warm up runs and are not recorded
+                for (int rep = -cfg.warmup; rep < cfg.reps; rep++)
+                {
+                    buffer_copy(&pointer_vals, &vals, n_threads);
+                    buffer_copy(&simd_vals, &vals, n_threads);
+
+                    double start = omp_get_wtime();
+                    pointer_map(map_op_func(op), pointer_vals.data, len, n_threads);
+                    double pointer_time = omp_get_wtime() - start;
+
+                    start = omp_get_wtime();
+                    simd_map(op, isa, simd_vals.data, len, n_threads);
+                    double simd_time = omp_get_wtime() - start;
+
+                    // Check that the two results are the same
+                    assert(memcmp(pointer_vals.data, simd_vals.data, (size_t)len * sizeof(int)) == 0);
+
+                    if (rep >= 0)
+                    {
+                        pointer_samples[rep] = pointer_time;
+                        simd_samples[rep] = simd_time;
+                    }
+                }
+
+                bench_stats pointer = bench_summarize(pointer_samples, cfg.reps);
+                bench_stats simd = bench_summarize(simd_samples, cfg.reps);
+                printf("%s (%s), %d threads\n  Pointer median: %lf\n  Specialized median: %lf\n",
+                       map_op_name(op), map_isa_name(isa), n_threads, pointer.median, simd.median);
+
+                // Write the data to the csv file
+                fprintf(fp, "%d,%d,%d,%s,%s", n_threads, cfg.reps, len, map_op_name(op), map_isa_name(isa));
+                bench_write_stats(fp, pointer);
+                bench_write_stats(fp, simd);
+                fprintf(fp, ",%lf", pointer.median / simd.median);
+                bench_write_binding(fp, false);
+                fprintf(fp, "\n");
+            }
+        }
+    }
+
+    fclose(fp); // Close the file
+    printf("Data written to simd_map_data.csv successfully\n");
+
+    free(pointer_samples);
+    free(simd_samples);
+    buffer_free(&vals);
+    buffer_free(&pointer_vals);
+    buffer_free(&simd_vals);
+
+    return 0;
+}
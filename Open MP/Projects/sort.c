@@ -0,0 +1,190 @@
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+
+#include "bench.h"
+#include "buffer.h"
+#include "sort.h"
+
+// void qsort_sort() -> Sorts vals with the C library's qsort() and records how long it took
+//
+// INPUTS
+//  - int vals[] -> The values to sort in place
+//  - int len -> The length of the value array
+//  - double* time -> Set to the time the sort took
+void qsort_sort(int vals[], int len, double *time)
+{
+    double start = omp_get_wtime();
+    qsort(vals, len, sizeof(int), sort_compare);
+    *time = omp_get_wtime() - start;
+}
+
+int main(int argc, char *argv[])
+{
+    bench_config cfg;
+    bench_defaults(&cfg);
+    int opt;
+    while ((opt = getopt(argc, argv, BENCH_OPTIONS)) != -1)
+    {
+        if (!bench_option(opt, optarg, &cfg))
+        {
+            printf("Usage: sort %s length MAX_VAL [input file] \n", BENCH_USAGE);
+            return 1;
+        }
+    }
+    // Shift the arguments so the positional ones start at argv[1]
+    argc -= optind - 1;
+    argv += optind - 1;
+
+    if (argc != 3 && argc != 4) {
+        printf("Invalid Arguments: please pass [options] length and MAX_VAL (and optionally a binary input file) \n");
+        return 1;
+    }
+    bench_setup(&cfg);
+
+    int len = atoi(argv[1]);
+    int MAX_VAL = atoi(argv[2]);
+
+    // The input either comes from a memory mapped binary file or is generated on the heap
+    int_buffer vals;
+    if (argc == 4)
+    {
+        if (!buffer_map_file(argv[3], &vals))
+        {
+            printf("Error mapping input file %s!\n", argv[3]);
+            exit(1);
+        }
+        // A length of 0 (or one longer than the file) means use the whole file
+        if (len > 0 && (size_t)len < vals.len)
+        {
+            vals.len = len;
+        }
+        len = vals.len;
+    }
+    else
+    {
+        vals = buffer_alloc(len, omp_get_max_threads());
+        bench_fill(&cfg, vals.data, len, MAX_VAL);
+    }
+
+    // Open the CSV data file
+    FILE *fp;
+    fp = fopen("Data/sort_data.csv", "w"); // Open for writing, overwriting if exists
+
+    if (fp == NULL)
+    {
+        printf("Error opening file!\n");
+        exit(1); // Exit with an error code
+    }
+
+    // Write header row. Serial is the LSD radix sort on one thread, Parallel the radix sort and Sample
+    // the sample sort on the row's threads, and Qsort the C library's qsort(). Speedup and Sample
+    // Speedup are against Serial, Qsort Speedup compares the parallel radix sort with qsort()
+    fprintf(fp, "Thread Count,Reps,Array Size");
+    bench_write_header(fp, "Serial");
+    bench_write_header(fp, "Parallel");
+    bench_write_header(fp, "Sample");
+    bench_write_header(fp, "Qsort");
+    fprintf(fp, ",Speedup,Sample Speedup,Qsort Speedup,Distribution");
+    bench_write_binding(fp, true);
+    fprintf(fp, "\n");
+
+    // The working copies are allocated once and refilled every run
+    int_buffer qsort_vals = buffer_alloc(len, 1);
+    int_buffer serial_vals = buffer_alloc(len, 1);
+    int_buffer radix_vals = buffer_alloc(len, omp_get_max_threads());
+    int_buffer sample_vals = buffer_alloc(len, omp_get_max_threads());
+    int_buffer tmp = buffer_alloc(len, omp_get_max_threads());
+    double *qsort_samples = malloc(cfg.reps * sizeof(double));
+    double *serial_samples = malloc(cfg.reps * sizeof(double));
+    double *radix_samples = malloc(cfg.reps * sizeof(double));
+    double *sample_samples = malloc(cfg.reps * sizeof(double));
+
+    // The serial baselines do not depend on the thread count, so they are timed once. qsort() is
+    // also the reference every sort is checked against.
+    // Negative runs are the warm up runs and are not recorded
+    for (int rep = -cfg.warmup; rep < cfg.reps; rep++)
+    {
+        double qsort_time;
+        buffer_copy(&qsort_vals, &vals, omp_get_max_threads());
+        qsort_sort(qsort_vals.data, len, &qsort_time);
+
+        buffer_copy(&serial_vals, &vals, omp_get_max_threads());
+        double start = omp_get_wtime();
+        radix_sort(serial_vals.data, tmp.data, len, 1);
+        double serial_time = omp_get_wtime() - start;
+        assert(memcmp(serial_vals.data, qsort_vals.data, (size_t)len * sizeof(int)) == 0);
+
+        if (rep >= 0)
+        {
+            qsort_samples[rep] = qsort_time;
+            serial_samples[rep] = serial_time;
+        }
+    }
+    bench_stats qsorted = bench_summarize(qsort_samples, cfg.reps);
+    bench_stats serial = bench_summarize(serial_samples, cfg.reps);
+
+    for (int t = 0; t < cfg.n_thread_counts; t++)
+    {
+        int n_threads = cfg.threads[t];
+
+        for (int rep = -cfg.warmup; rep < cfg.reps; rep++)
+        {
+            buffer_copy(&radix_vals, &vals, n_threads);
+            double start = omp_get_wtime();
+            radix_sort(radix_vals.data, tmp.data, len, n_threads);
+            double radix_time = omp_get_wtime() - start;
+
+            buffer_copy(&sample_vals, &vals, n_threads);
+            start = omp_get_wtime();
+            sample_sort(sample_vals.data, tmp.data, len, n_threads);
+            double sample_time = omp_get_wtime() - start;
+
+            // Check that both sorts agree with qsort()
+            assert(memcmp(radix_vals.data, qsort_vals.data, (size_t)len * sizeof(int)) == 0);
+            assert(memcmp(sample_vals.data, qsort_vals.data, (size_t)len * sizeof(int)) == 0);
+
+            if (rep >= 0)
+            {
+                radix_samples[rep] = radix_time;
+                sample_samples[rep] = sample_time;
+            }
+        }
+        printf("Assertion 1 passed: The sorted results are the same\n");
+
+        bench_stats radix = bench_summarize(radix_samples, cfg.reps);
+        bench_stats sample = bench_summarize(sample_samples, cfg.reps);
+        printf("%d threads\n  Serial radix median: %lf\n  Radix median: %lf (p95 %lf)\n  Sample median: %lf (p95 %lf)\n  qsort median: %lf\n",
+               n_threads, serial.median, radix.median, radix.p95, sample.median, sample.p95, qsorted.median);
+
+        // Write the data to the csv file
+        fprintf(fp, "%d,%d,%d", n_threads, cfg.reps, len);
+        bench_write_stats(fp, serial);
+        bench_write_stats(fp, radix);
+        bench_write_stats(fp, sample);
+        bench_write_stats(fp, qsorted);
+        fprintf(fp, ",%lf,%lf,%lf,%s", serial.median / radix.median, serial.median / sample.median,
+                qsorted.median / radix.median, argc == 4 ? "file" : rng_name(&cfg.dist));
+        bench_write_binding(fp, false);
+        fprintf(fp, "\n");
+    }
+
+    fclose(fp); // Close the file
+    printf("Data written to sort_data.csv successfully\n");
+
+    free(qsort_samples);
+    free(serial_samples);
+    free(radix_samples);
+    free(sample_samples);
+    buffer_free(&qsort_vals);
+    buffer_free(&serial_vals);
+    buffer_free(&radix_vals);
+    buffer_free(&sample_vals);
+    buffer_free(&tmp);
+    buffer_free(&vals);
+
+    return 0;
+}
@@ -0,0 +1,193 @@
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <stdbool.h>
+#include <unistd.h>
+
+#include "bench.h"
+#include "buffer.h"
+#include "steal.h"
+
+// int cost_function() -> Takes time proportional to x, the same as map_function() in map.c. The
+//  counter is volatile so the compiler cannot fold the loop into a constant time expression
+int cost_function(int x)
+{
+    volatile int sum = 0;
+    for (int i = 0; i < x; i++)
+    {
+        sum += 1;
+    }
+
+    return sum;
+}
+
+// void cost_range_body() -> Maps vals[begin, end) in place with cost_function()
+void cost_range_body(long begin, long end, void *ctx)
+{
+    int *vals = ctx;
+    for (long i = begin; i < end; i++)
+    {
+        vals[i] = cost_function(vals[i]);
+    }
+}
+
+// void fill_input() -> Fills vals with one of the benchmark distributions
+//
+// INPUTS
+//  - const bench_config* cfg -> The seed the values are drawn with
+//  - const rng_distribution* dist -> The distribution to draw from, e.g. Zipf (most values small
+//      and a few close to MAX_VAL) or sorted (increasing, so the last block of a static schedule
+//      holds most of the work). NULL makes every value MAX_VAL / 2, so every element costs the same
+//  - int vals[] -> The array to fill
+//  - int len -> The length of the array
+//  - int MAX_VAL -> The largest value
+void fill_input(const bench_config *cfg, const rng_distribution *dist, int vals[], int len, int MAX_VAL)
+{
+    if (dist != NULL)
+    {
+        rng_fill(dist, cfg->seed, vals, len, MAX_VAL, omp_get_max_threads());
+        return;
+    }
+
+#pragma omp parallel for schedule(static)
+    for (int i = 0; i < len; i++)
+    {
+        vals[i] = MAX_VAL / 2;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    bench_config cfg;
+    bench_defaults(&cfg);
+    // Without -d every distribution below is run, with it only the one asked for
+    bool one_distribution = false;
+    int opt;
+    while ((opt = getopt(argc, argv, BENCH_OPTIONS)) != -1)
+    {
+        one_distribution = one_distribution || opt == 'd';
+        if (!bench_option(opt, optarg, &cfg))
+        {
+            printf("Usage: steal_bench %s length MAX_VAL [chunk size] \n", BENCH_USAGE);
+            return 1;
+        }
+    }
+    // Shift the arguments so the positional ones start at argv[1]
+    argc -= optind - 1;
+    argv += optind - 1;
+
+    if (argc != 3 && argc != 4) {
+        printf("Invalid Arguments: please pass [options] length and MAX_VAL (and optionally the dynamic chunk size) \n");
+        return 1;
+    }
+    bench_setup(&cfg);
+
+    int len = atoi(argv[1]);
+    int MAX_VAL = atoi(argv[2]);
+    int chunk = argc == 4 ? atoi(argv[3]) : 1;
+
+    int_buffer input = buffer_alloc(len, omp_get_max_threads());
+    int_buffer dynamic_vals = buffer_alloc(len, omp_get_max_threads());
+    int_buffer steal_vals = buffer_alloc(len, omp_get_max_threads());
+    double *dynamic_samples = malloc(cfg.reps * sizeof(double));
+    double *steal_samples = malloc(cfg.reps * sizeof(double));
+    double *steal_counts = malloc(cfg.reps * sizeof(double));
+
+    // Open the CSV data file
+    FILE *fp;
+    fp = fopen("Data/steal_data.csv", "w"); // Open for writing, overwriting if exists
+
+    if (fp == NULL)
+    {
+        printf("Error opening file!\n");
+        exit(1); // Exit with an error code
+    }
+
+    // Write header row. Steals is the median number of steals of the timed runs
+    fprintf(fp, "Thread Count,Reps,Array Size,Chunk Size,Distribution");
+    bench_write_header(fp, "Dynamic");
+    bench_write_header(fp, "Steal");
+    fprintf(fp, ",Speedup,Steals");
+    bench_write_binding(fp, true);
+    fprintf(fp, "\n");
+
+    // Equal cost elements, a few very expensive ones, and the expensive ones all at the end
+    rng_distribution zipf = {RNG_ZIPF, 1.0};
+    rng_distribution sorted = {RNG_SORTED, 1.0};
+    const rng_distribution *distributions[] = {NULL, &zipf, &sorted};
+    int n_distributions = 3;
+    if (one_distribution)
+    {
+        distributions[0] = &cfg.dist;
+        n_distributions = 1;
+    }
+
+    for (int d = 0; d < n_distributions; d++)
+    {
+        const char *name = distributions[d] == NULL ? "constant" : rng_name(distributions[d]);
+        fill_input(&cfg, distributions[d], input.data, len, MAX_VAL);
+
+        for (int t = 0; t < cfg.n_thread_counts; t++)
+        {
+            int n_threads = cfg.threads[t];
+
+            // Negative runs are the warm up runs and are not recorded
+            for (int rep = -cfg.warmup; rep < cfg.reps; rep++)
+            {
+                buffer_copy(&dynamic_vals, &input, n_threads);
+                buffer_copy(&steal_vals, &input, n_threads);
+
+                double start = omp_get_wtime();
+#pragma omp parallel for schedule(dynamic, chunk) num_threads(n_threads)
+                for (int i = 0; i < len; i++)
+                {
+                    dynamic_vals.data[i] = cost_function(dynamic_vals.data[i]);
+                }
+                double dynamic_time = omp_get_wtime() - start;
+
+                start = omp_get_wtime();
+                long steals = steal_for(len, 0, cost_range_body, steal_vals.data, n_threads);
+                double steal_time = omp_get_wtime() - start;
+
+                // Check that the two results are the same
+                assert(memcmp(dynamic_vals.data, steal_vals.data, (size_t)len * sizeof(int)) == 0);
+
+                if (rep >= 0)
+                {
+                    dynamic_samples[rep] = dynamic_time;
+                    steal_samples[rep] = steal_time;
+                    // Kept with the times so the steal counts get the same median
+                    steal_counts[rep] = steals;
+                }
+            }
+
+            bench_stats dynamic = bench_summarize(dynamic_samples, cfg.reps);
+            bench_stats steal = bench_summarize(steal_samples, cfg.reps);
+            double steals = bench_summarize(steal_counts, cfg.reps).median;
+            printf("%s, %d threads\n  Dynamic median: %lf\n  Steal median: %lf (%.0lf steals)\n",
+                   name, n_threads, dynamic.median, steal.median, steals);
+
+            // Write the data to the csv file
+            fprintf(fp, "%d,%d,%d,%d,%s", n_threads, cfg.reps, len, chunk, name);
+            bench_write_stats(fp, dynamic);
+            bench_write_stats(fp, steal);
+            fprintf(fp, ",%lf,%.0lf", dynamic.median / steal.median, steals);
+            bench_write_binding(fp, false);
+            fprintf(fp, "\n");
+        }
+    }
+
+    fclose(fp); // Close the file
+    printf("Data written to steal_data.csv successfully\n");
+
+    free(dynamic_samples);
+    free(steal_samples);
+    free(steal_counts);
+    buffer_free(&input);
+    buffer_free(&dynamic_vals);
+    buffer_free(&steal_vals);
+
+    return 0;
+}
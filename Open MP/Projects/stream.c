@@ -0,0 +1,155 @@
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "pipeline.h"
+#include "stream.h"
+
+int main(int argc, char *argv[])
+{
+    // -c sets the number of integers per chunk, -n the number of threads the kernels use
+    // and -o a binary file the surviving values are written to when there is no reduction
+    size_t chunk_len = STREAM_CHUNK_LEN;
+    int n_threads = omp_get_max_threads();
+    const char *out_path = NULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "c:n:o:")) != -1)
+    {
+        if (opt == 'c' && atol(optarg) > 0)
+        {
+            chunk_len = atol(optarg);
+        }
+        else if (opt == 'n' && atoi(optarg) > 0)
+        {
+            n_threads = atoi(optarg);
+        }
+        else if (opt == 'o')
+        {
+            out_path = optarg;
+        }
+        else
+        {
+            printf("Usage: stream [-c chunk length] [-n threads] [-o output file] pipeline input file \n");
+            return 1;
+        }
+    }
+    // Shift the arguments so the positional ones start at argv[1]
+    argc -= optind - 1;
+    argv += optind - 1;
+
+    if (argc != 3) {
+        printf("Invalid Arguments: please pass [options] a pipeline (such as filter:even or map:square,reduce:add) and a binary or .csv input file \n");
+        return 1;
+    }
+
+    // A pipeline ending in a reduction folds every chunk into one value. Without one the
+    // surviving values of every chunk are appended to the output file, if there is one
+    pipeline p;
+    if (!pipeline_parse(argv[1], &p))
+    {
+        printf("Invalid Arguments: %s is not a pipeline. Stages are map:count|square|affine|abs, filter:even|odd|positive and an optional final reduce:add|mult|max|min|gcd \n", argv[1]);
+        return 1;
+    }
+
+    FILE *out = NULL;
+    if (out_path != NULL && p.reduce == NULL)
+    {
+        out = fopen(out_path, "wb");
+        if (out == NULL)
+        {
+            printf("Error opening output file %s!\n", out_path);
+            exit(1);
+        }
+    }
+
+    stream s;
+    if (!stream_open(argv[2], chunk_len, n_threads, &s))
+    {
+        printf("Error opening input file %s!\n", argv[2]);
+        exit(1);
+    }
+
+    // While the kernels work on one chunk the reader thread loads the next
+    double start = omp_get_wtime();
+    double compute_time = 0;
+    long long n_elements = 0;
+    long long n_out = 0;
+    long n_chunks = 0;
+    int result = p.reduce != NULL ? p.reduce->identity : 0;
+
+    int *chunk;
+    size_t len;
+    while (stream_next(&s, &chunk, &len))
+    {
+        double chunk_start = omp_get_wtime();
+        if (p.reduce != NULL)
+        {
+            // Chunks arrive in order, so the partials only need the operator to be associative
+            result = p.reduce->func(result, pipeline_run(&p, chunk, len, n_threads));
+        }
+        else
+        {
+            long kept = pipeline_apply(&p, chunk, len, n_threads);
+            if (out != NULL && fwrite(chunk, sizeof(int), kept, out) != (size_t)kept)
+            {
+                printf("Error writing output file %s!\n", out_path);
+                exit(1);
+            }
+            n_out += kept;
+        }
+        compute_time += omp_get_wtime() - chunk_start;
+        n_elements += len;
+        n_chunks++;
+    }
+    double total_time = omp_get_wtime() - start;
+    if (s.bad_value)
+    {
+        printf("Error reading input file %s: a field is not an int!\n", argv[2]);
+        exit(1);
+    }
+
+    long long bytes = s.bytes_read;
+    double read_time = s.read_time;
+    double wait_time = s.wait_time;
+    bool csv = s.csv;
+    stream_close(&s);
+    if (out != NULL)
+    {
+        fclose(out);
+    }
+
+    printf("%s over %lld values in %ld chunks\n", argv[1], n_elements, n_chunks);
+    if (p.reduce != NULL)
+    {
+        printf("  Result: %d\n", result);
+    }
+    else
+    {
+        printf("  Output length: %lld\n", n_out);
+    }
+    printf("  Time: %lf (%.2lf GB/s)\n  Read time: %lf\n  Compute time: %lf\n  Time waiting for reads: %lf\n",
+           total_time, bytes / total_time / 1e9, read_time, compute_time, wait_time);
+
+    // Open the CSV data file
+    FILE *fp;
+    fp = fopen("Data/stream_data.csv", "w"); // Open for writing, overwriting if exists
+
+    if (fp == NULL)
+    {
+        printf("Error opening file!\n");
+        exit(1); // Exit with an error code
+    }
+
+    // The pipeline is quoted because it contains commas. A reduction outputs its one result
+    fprintf(fp, "Thread Count,Chunk Size,Format,Pipeline,Chunks,Values,Bytes,Time,GB/s,Read Time,Compute Time,Wait Time,Result,Output Length\n");
+    fprintf(fp, "%d,%zu,%s,\"%s\",%ld,%lld,%lld,%lf,%lf,%lf,%lf,%lf,%d,%lld\n", n_threads, chunk_len, csv ? "csv" : "binary",
+            argv[1], n_chunks, n_elements, bytes, total_time, bytes / total_time / 1e9, read_time, compute_time, wait_time,
+            result, p.reduce != NULL ? 1 : n_out);
+
+    fclose(fp); // Close the file
+    printf("Data written to stream_data.csv successfully\n");
+
+    return 0;
+}
@@ -0,0 +1,175 @@
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <assert.h>
+#include <unistd.h>
+
+#include "bench.h"
+#include "buffer.h"
+#include "reduction.h"
+#include "schedule.h"
+#include "wide_reduce.h"
+
+// serial_wide() -> The plain loop version of wide_reduce(), used to check its results
+// INPUTS
+//  - wide_op op -> The operator to reduce with
+//  - const int vals[] -> The values to reduce
+//  - long len -> The length of the value array
+long long serial_wide(wide_op op, const int vals[], long len)
+{
+    long long sum = 0;
+    unsigned long long product = 1;
+    int max = INT_MIN;
+    int min = INT_MAX;
+    for (long i = 0; i < len; i++)
+    {
+        sum += vals[i];
+        product *= (unsigned long long)vals[i];
+        max = vals[i] > max ? vals[i] : max;
+        min = vals[i] < min ? vals[i] : min;
+    }
+
+    switch (op)
+    {
+    case WIDE_ADD:
+        return sum;
+    case WIDE_MULT:
+        return (long long)product;
+    case WIDE_MAX:
+        return max;
+    default:
+        return min;
+    }
+}
+
+// double gb_per_sec() -> The bandwidth of moving bytes in the given time, in GB/s
+double gb_per_sec(double bytes, double time)
+{
+    return bytes / time / 1e9;
+}
+
+int main(int argc, char *argv[])
+{
+    bench_config cfg;
+    bench_defaults(&cfg);
+    int opt;
+    while ((opt = getopt(argc, argv, BENCH_OPTIONS)) != -1)
+    {
+        if (!bench_option(opt, optarg, &cfg))
+        {
+            printf("Usage: wide_reduce_bench %s length MAX_VAL \n", BENCH_USAGE);
+            return 1;
+        }
+    }
+    // Shift the arguments so the positional ones start at argv[1]
+    argc -= optind - 1;
+    argv += optind - 1;
+
+    if (argc != 3) {
+        printf("Invalid Arguments: please pass [options] length and MAX_VAL \n");
+        return 1;
+    }
+    bench_setup(&cfg);
+
+    // The int kernels follow the runtime schedule, compare against them with the static one
+    schedule_policy policy = {omp_sched_static, 0, false};
+    schedule_apply(&policy);
+
+    int len = atoi(argv[1]);
+    int MAX_VAL = atoi(argv[2]);
+
+    int_buffer vals = buffer_alloc(len, omp_get_max_threads());
+    bench_fill(&cfg, vals.data, len, MAX_VAL);
+    // The copy target for the STREAM style peak bandwidth measurement
+    int_buffer copy_vals = buffer_alloc(len, omp_get_max_threads());
+    double *int_samples = malloc(cfg.reps * sizeof(double));
+    double *wide_samples = malloc(cfg.reps * sizeof(double));
+    double *copy_samples = malloc(cfg.reps * sizeof(double));
+    double bytes = (double)len * sizeof(int);
+
+    // Open the CSV data file
+    FILE *fp;
+    fp = fopen("Data/wide_reduce_data.csv", "w"); // Open for writing, overwriting if exists
+
+    if (fp == NULL)
+    {
+        printf("Error opening file!\n");
+        exit(1); // Exit with an error code
+    }
+
+    // Write header row. Int is the int kernel from reduction.h, Wide the wide accumulator kernel.
+    // Copy GB/s is the STREAM Copy bandwidth (read plus write) at the same thread count
+    fprintf(fp, "Thread Count,Reps,Array Size,Operator");
+    bench_write_header(fp, "Int");
+    bench_write_header(fp, "Wide");
+    fprintf(fp, ",Speedup,Int GB/s,Wide GB/s,Copy GB/s,Fraction Of Copy,Result,Overflow");
+    bench_write_binding(fp, true);
+    fprintf(fp, "\n");
+
+    for (int op = 0; op < WIDE_N_OPS; op++)
+    {
+        const reduce_operator *int_op = reduce_find(wide_op_name(op));
+        long long expected = serial_wide(op, vals.data, len);
+
+        for (int t = 0; t < cfg.n_thread_counts; t++)
+        {
+            int n_threads = cfg.threads[t];
+            wide_result wide_result = {0, false};
+
+            // Negative runs are the warm up runs and are not recorded
+            for (int rep = -cfg.warmup; rep < cfg.reps; rep++)
+            {
+                double copy_time = buffer_copy(&copy_vals, &vals, n_threads);
+
+                double start = omp_get_wtime();
+                int int_result = reduce_run(int_op, vals.data, len, n_threads);
+                double int_time = omp_get_wtime() - start;
+
+                start = omp_get_wtime();
+                wide_result = wide_reduce(op, vals.data, len, n_threads);
+                double wide_time = omp_get_wtime() - start;
+
+                // The wide result is exact, and the int kernels return its low 32 bits
+                assert(wide_result.value == expected);
+                assert(int_result == (int)(unsigned)wide_result.value);
+
+                if (rep >= 0)
+                {
+                    int_samples[rep] = int_time;
+                    wide_samples[rep] = wide_time;
+                    copy_samples[rep] = copy_time;
+                }
+            }
+
+            bench_stats int_stats = bench_summarize(int_samples, cfg.reps);
+            bench_stats wide = bench_summarize(wide_samples, cfg.reps);
+            bench_stats copy = bench_summarize(copy_samples, cfg.reps);
+            double copy_rate = gb_per_sec(2 * bytes, copy.median);
+            double wide_rate = gb_per_sec(bytes, wide.median);
+            printf("%s, %d threads\n  Result: %lld%s\n  Int median: %lf\n  Wide median: %lf (%.2lf GB/s, %.0lf%% of copy)\n",
+                   wide_op_name(op), n_threads, wide_result.value, wide_result.overflow ? " (overflows int)" : "",
+                   int_stats.median, wide.median, wide_rate, 100 * wide_rate / copy_rate);
+
+            // Write the data to the csv file
+            fprintf(fp, "%d,%d,%d,%s", n_threads, cfg.reps, len, wide_op_name(op));
+            bench_write_stats(fp, int_stats);
+            bench_write_stats(fp, wide);
+            fprintf(fp, ",%lf,%lf,%lf,%lf,%lf,%lld,%d", int_stats.median / wide.median, gb_per_sec(bytes, int_stats.median),
+                    wide_rate, copy_rate, wide_rate / copy_rate, wide_result.value, wide_result.overflow);
+            bench_write_binding(fp, false);
+            fprintf(fp, "\n");
+        }
+    }
+
+    fclose(fp); // Close the file
+    printf("Data written to wide_reduce_data.csv successfully\n");
+
+    free(int_samples);
+    free(wide_samples);
+    free(copy_samples);
+    buffer_free(&vals);
+    buffer_free(&copy_vals);
+
+    return 0;
+}
@@ -9,13 +9,12 @@ int main(int argc, char **argv)
 
     int i;
     double x, pi, sum = 0.0;
-#pragma omp parallel for reduction(+ : sum)
+    // The parallel for has to sit directly on the loop, and x has to be private
+#pragma omp parallel for private(x) reduction(+ : sum)
+    for (i = 0; i < num_steps; i++)
     {
-        for (i = 0; i < num_steps; i++)
-        {
-            x = (i + 0.5) * step;
-            sum = sum + 4.0 / (1.0 + x * x);
-        }
+        x = (i + 0.5) * step;
+        sum = sum + 4.0 / (1.0 + x * x);
     }
     pi = step * sum;
 